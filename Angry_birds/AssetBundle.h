@@ -0,0 +1,188 @@
+#ifndef ASSETBUNDLE_H
+#define ASSETBUNDLE_H
+
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdint.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Assets baked by the packer (packer.cpp, `make bundle`) into one file that is mapped, not parsed.
+//
+// Layout, in the byte order of the machine that packed it:
+//   BundleHeader
+//   BundleEntry[Count]       name and place of every asset
+//   asset data               each asset starts on a BundleAlignment boundary
+//
+// Assets are named after the source file they replace, fonts add their settings after an '@'. Each entry
+// records the size and modification time its source had when packed; an asset whose source has changed
+// since is ignored, so the game reads the edited file until the bundle is baked again.
+// What an asset holds depends on its source:
+//   images (.png)            BakedImage, then the decoded texels, rows top to bottom
+//   shaders                  the source text as is, not zero terminated
+//   fonts                    BakedGlyphs, then BakedGlyph[Count], then the atlas images, see BakedFontName
+const char BundleMagic[8] = { 'A', 'B', 'B', 'U', 'N', 'D', 'L', 'E' };
+const uint32_t BundleVersion = 2;
+const size_t BundleAlignment = 16;
+
+struct BundleHeader {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t Count;
+};
+
+struct BundleEntry {
+    char Name[48];       // zero padded
+    uint64_t Offset;     // from the start of the file
+    uint64_t Size;
+    uint64_t SourceSize; // of the source file when packed
+    int64_t SourceTime;  // its st_mtime then
+};
+
+// The file an asset was made from: its name up to any '@'
+inline std::string BundleSourcePath(const std::string &name)
+{
+    return name.substr(0, name.find('@'));
+}
+
+struct BakedImage {
+    uint32_t Width, Height;
+    uint32_t Channels;   // 3, as SOIL_LOAD_RGB gives them
+    uint32_t Reserved;
+};
+
+struct BakedGlyphs {
+    uint32_t Count;
+    uint32_t Reserved;
+};
+
+// GlyphImage of one code point, Pixels is an offset from the start of the font asset
+struct BakedGlyph {
+    uint32_t Codepoint;
+    int32_t Width, Height;
+    float Left, Top, Advance;
+    uint64_t Pixels;
+};
+
+// Glyphs depend on the rasterizer settings as well as the font file
+inline std::string BakedFontName(const std::string &fontPath, bool sdf, int rasterSize)
+{
+    std::stringstream name;
+    name << fontPath << (sdf ? "@sdf" : "@bitmap") << rasterSize;
+    return name.str();
+}
+
+// Read-only view of a mapped bundle. The mapping lives as long as the bundle, so pointers handed out
+// by Find stay valid and can be uploaded straight to the GPU.
+class AssetBundle
+{
+public:
+    // The bundle the game loads its assets from, see ReadTextAsset
+    static AssetBundle& Instance()
+    {
+        static AssetBundle bundle;
+        return bundle;
+    }
+
+    AssetBundle() : data(NULL), size(0), entries(NULL), count(0) {}
+    ~AssetBundle() { Close(); }
+
+    // Maps the file, false if it is missing or not a bundle of this version
+    bool Open(const char* path)
+    {
+        Close();
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(BundleHeader))
+        {
+            void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                data = (const char*)mapping;
+                size = info.st_size;
+            }
+        }
+        close(fd);
+        if (!data)
+            return false;
+
+        const BundleHeader *header = (const BundleHeader*)data;
+        entries = (const BundleEntry*)(header + 1);
+        count = header->Count;
+        bool valid = memcmp(header->Magic, BundleMagic, sizeof(BundleMagic)) == 0 && header->Version == BundleVersion
+            && count <= (size - sizeof(BundleHeader)) / sizeof(BundleEntry);
+        for (uint32_t i = 0; valid && i < count; i++)
+            valid = entries[i].Offset <= size && entries[i].Size <= size - entries[i].Offset;
+        if (!valid)
+        {
+            std::cout << "ERROR::ASSETS: " << path << " is not a version " << BundleVersion << " asset bundle" << std::endl;
+            Close();
+        }
+        return data != NULL;
+    }
+
+    void Close()
+    {
+        if (data)
+            munmap((void*)data, size);
+        data = NULL;
+        size = 0;
+        entries = NULL;
+        count = 0;
+    }
+
+    bool IsOpen() const { return data != NULL; }
+    uint32_t Count() const { return count; }
+
+    // The asset named after the given source, NULL if the bundle does not have it or its source changed
+    // since it was packed. Without the source file, as in a bundle shipped on its own, the asset is used.
+    const void* Find(const std::string &name, size_t &assetSize) const
+    {
+        for (uint32_t i = 0; i < count; i++)
+            if (strncmp(entries[i].Name, name.c_str(), sizeof(entries[i].Name)) == 0)
+            {
+                struct stat source;
+                if (stat(BundleSourcePath(name).c_str(), &source) == 0
+                    && ((uint64_t)source.st_size != entries[i].SourceSize || (int64_t)source.st_mtime != entries[i].SourceTime))
+                {
+                    std::cout << "WARNING::ASSETS: " << name << " changed since the bundle was made, reading the file (run make bundle)" << std::endl;
+                    return NULL;
+                }
+                assetSize = entries[i].Size;
+                return data + entries[i].Offset;
+            }
+        return NULL;
+    }
+
+private:
+    const char *data;
+    size_t size;
+    const BundleEntry *entries;
+    uint32_t count;
+
+    AssetBundle(const AssetBundle&);
+    AssetBundle& operator=(const AssetBundle&);
+};
+
+// Contents of a text file, from the game's bundle when it has it. Empty if the file cannot be read.
+inline std::string ReadTextAsset(const char* path)
+{
+    size_t size;
+    const char *baked = (const char*)AssetBundle::Instance().Find(path, size);
+    if (baked)
+        return std::string(baked, size);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+#endif
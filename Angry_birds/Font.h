@@ -0,0 +1,259 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <list>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <algorithm>
+#include <iostream>
+
+#include "GlyphRasterizer.h"
+#include "AssetBundle.h"
+#include "GpuResource.h"
+
+// Metrics are in pixels at the font's nominal size, whatever size the atlas was rasterized at
+struct Character {
+    glm::vec2 Size;      // Size of glyph
+    glm::vec2 Bearing;   // Offset from baseline to left/top of glyph
+    GLfloat Advance;     // Horizontal offset to advance to next glyph
+    glm::vec2 UVMin;     // Top-left corner of the glyph inside its atlas page
+    glm::vec2 UVMax;     // Bottom-right corner of the glyph inside its atlas page
+    GLint Layer;         // Atlas page, -1 for glyphs with nothing to draw such as space
+};
+
+// Glyph cache over a fixed number of atlas pages (layers of one GL_TEXTURE_2D_ARRAY).
+// Code points are rasterized on first use into fixed-size cells. When every cell is taken the least
+// recently used glyph gives up its cell, so texture memory stays the same however many distinct
+// characters the text uses. Glyphs looked up since the last ReleasePins() are never evicted because
+// quads waiting in a batch still point at them.
+// Glyphs the asset bundle has prebaked are copied from it, FreeType is only opened for the others.
+class Font
+{
+public:
+    GpuTexture AtlasID;
+    GLsizei PageSize, Pages;
+    FontMode Mode;
+
+    Font(const GLchar* fontPath, GLuint pixelSize, FontMode mode = FONT_BITMAP, GLsizei pageSize = 512, GLsizei pages = 4)
+        : PageSize(pageSize), Pages(pages), Mode(mode), fontPath(fontPath), pixelSize(pixelSize), rasterizer(NULL),
+          baked(NULL), generation(0)
+    {
+        int em = GlyphRasterizer::RasterSize(Mode, pixelSize);
+        findBakedGlyphs(em);
+        // Atlas texels to nominal pixels
+        toNominal = (GLfloat)pixelSize / em;
+
+        // Cells fit a glyph a quarter larger than the em square plus the SDF margin and a 1 texel gutter,
+        // the gutter stays empty so linear filtering never picks up the neighbouring cell
+        cellSize = em * 5 / 4 + (Mode == FONT_SDF ? 2 * GlyphRasterizer::SDFSpread : 0) + 2;
+        cellsPerRow = PageSize / cellSize;
+        for (int cell = cellsPerRow * cellsPerRow * Pages - 1; cell >= 0; cell--)
+            freeCells.push_back(cell);
+
+        AtlasID = GpuTexture::Create();
+        GlState::Instance().BindTexture(GL_TEXTURE_2D_ARRAY, AtlasID);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, PageSize, PageSize, Pages, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+        AtlasID.SetBytes((size_t)PageSize * PageSize * Pages);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    ~Font()
+    {
+        delete rasterizer;
+    }
+
+    // Returns the glyph for a code point, rasterizing it if it is not cached.
+    // A code point that cannot be loaded is cached as a blank half an em wide, so it is only tried once.
+    // When every cell is pinned by glyphs used since the last ReleasePins() the glyph comes back with its
+    // metrics but Layer -1, the text still advances past it and it gets a cell once the pins are released.
+    const Character& Glyph(uint32_t codepoint)
+    {
+        std::unordered_map<uint32_t, CacheEntry>::iterator it = cache.find(codepoint);
+        if (it != cache.end())
+        {
+            CacheEntry &entry = it->second;
+            if (entry.cell >= 0)
+            {
+                lru.splice(lru.begin(), lru, entry.lru);
+                entry.used = generation;
+            }
+            return entry.glyph;
+        }
+
+        CacheEntry entry;
+        entry.glyph.Size = entry.glyph.Bearing = glm::vec2(0.0f);
+        entry.glyph.Advance = pixelSize / 2.0f;
+        entry.glyph.Layer = -1;
+        entry.cell = -1;
+        entry.used = generation;
+        GlyphImage image;
+        if (load(codepoint, image))
+        {
+            entry.glyph.Size = glm::vec2(image.Width * toNominal, image.Height * toNominal);
+            entry.glyph.Bearing = glm::vec2(image.Left * toNominal, image.Top * toNominal);
+            entry.glyph.Advance = image.Advance * toNominal;
+            if (image.Width > 0 && image.Height > 0)
+            {
+                entry.cell = allocateCell();
+                if (entry.cell < 0)
+                {
+                    unplaced = entry.glyph;
+                    return unplaced;
+                }
+                upload(entry.cell, image, entry.glyph);
+                lru.push_front(codepoint);
+                entry.lru = lru.begin();
+            }
+        }
+        return cache.insert(std::make_pair(codepoint, entry)).first->second.glyph;
+    }
+
+    // Called once the quads referencing the glyphs looked up so far have been drawn
+    void ReleasePins() { generation++; }
+
+    // Reads one code point starting at text[i] and moves i past it, malformed sequences give U+FFFD
+    static uint32_t DecodeUTF8(const std::string &text, size_t &i)
+    {
+        unsigned char c = text[i++];
+        if (c < 0x80)
+            return c;
+        int extra = (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : -1;
+        if (extra < 0)
+            return 0xFFFD;
+        uint32_t codepoint = c & (0x3F >> extra);
+        for (int k = 0; k < extra; k++)
+        {
+            if (i >= text.size() || ((unsigned char)text[i] & 0xC0) != 0x80)
+                return 0xFFFD;
+            codepoint = (codepoint << 6) | ((unsigned char)text[i++] & 0x3F);
+        }
+        static const uint32_t smallest[4] = { 0, 0x80, 0x800, 0x10000 };
+        if (codepoint < smallest[extra] || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+            return 0xFFFD;
+        return codepoint;
+    }
+
+private:
+    struct CacheEntry {
+        Character glyph;
+        int cell;                              // -1 when the glyph has no pixels or failed to load
+        uint64_t used;                         // generation of the last lookup
+        std::list<uint32_t>::iterator lru;
+    };
+
+    std::string fontPath;
+    int pixelSize;
+    GlyphRasterizer *rasterizer;               // opened on the first glyph that is not baked
+    const char *baked;                         // font asset in the mapped bundle, NULL without one
+    std::unordered_map<uint32_t, const BakedGlyph*> bakedGlyphs;
+    GLfloat toNominal;
+    int cellSize, cellsPerRow;
+    uint64_t generation;
+    std::unordered_map<uint32_t, CacheEntry> cache;
+    std::list<uint32_t> lru;                   // code points holding a cell, most recently used first
+    std::vector<int> freeCells;
+    std::vector<unsigned char> cellPixels;
+    Character unplaced;                        // last glyph that found no free cell, not cached
+
+    // Indexes the glyphs baked for this font at these settings, if the bundle has them
+    void findBakedGlyphs(int rasterSize)
+    {
+        size_t size;
+        baked = (const char*)AssetBundle::Instance().Find(BakedFontName(fontPath, Mode == FONT_SDF, rasterSize), size);
+        if (!baked)
+            return;
+        const BakedGlyphs *header = (const BakedGlyphs*)baked;
+        const BakedGlyph *glyphs = (const BakedGlyph*)(header + 1);
+        if (size < sizeof(BakedGlyphs) || header->Count > (size - sizeof(BakedGlyphs)) / sizeof(BakedGlyph))
+        {
+            std::cout << "ERROR::FONT: Baked glyphs of " << fontPath << " are truncated" << std::endl;
+            baked = NULL;
+            return;
+        }
+        // Glyphs whose pixels fall outside the asset are rasterized instead
+        for (uint32_t i = 0; i < header->Count; i++)
+        {
+            const BakedGlyph &glyph = glyphs[i];
+            if (glyph.Width < 0 || glyph.Height < 0)
+                continue;
+            uint64_t pixels = (uint64_t)glyph.Width * glyph.Height;
+            if (glyph.Pixels <= size && pixels <= size - glyph.Pixels)
+                bakedGlyphs[glyph.Codepoint] = &glyph;
+        }
+    }
+
+    // The atlas image of a code point, baked if possible and rasterized otherwise
+    bool load(uint32_t codepoint, GlyphImage &image)
+    {
+        std::unordered_map<uint32_t, const BakedGlyph*>::const_iterator it = bakedGlyphs.find(codepoint);
+        if (it != bakedGlyphs.end())
+        {
+            const BakedGlyph &glyph = *it->second;
+            image.Width = glyph.Width;
+            image.Height = glyph.Height;
+            image.Left = glyph.Left;
+            image.Top = glyph.Top;
+            image.Advance = glyph.Advance;
+            image.Pixels = (const unsigned char*)baked + glyph.Pixels;
+            return true;
+        }
+        if (!rasterizer)
+            rasterizer = new GlyphRasterizer(fontPath.c_str(), Mode, pixelSize);
+        return rasterizer->Rasterize(codepoint, image);
+    }
+
+    // A free cell, or the one held by the least recently used glyph unless that glyph is pinned
+    int allocateCell()
+    {
+        if (!freeCells.empty())
+        {
+            int cell = freeCells.back();
+            freeCells.pop_back();
+            return cell;
+        }
+        if (lru.empty())
+            return -1;
+        std::unordered_map<uint32_t, CacheEntry>::iterator victim = cache.find(lru.back());
+        // Everything else was used even more recently, so it is pinned as well
+        if (victim->second.used == generation)
+            return -1;
+        int cell = victim->second.cell;
+        lru.pop_back();
+        cache.erase(victim);
+        return cell;
+    }
+
+    // Writes the image into the cell, clearing whatever glyph lived there before
+    void upload(int cell, const GlyphImage &image, Character &character)
+    {
+        int w = image.Width, h = image.Height;
+        int layer = cell / (cellsPerRow * cellsPerRow);
+        int x = (cell % cellsPerRow) * cellSize, y = (cell / cellsPerRow % cellsPerRow) * cellSize;
+        int cw = std::min(w, cellSize - 2), ch = std::min(h, cellSize - 2);
+        if (cw < w || ch < h)
+            std::cout << "WARNING::FONT: Glyph of " << w << "x" << h << " clipped to its atlas cell" << std::endl;
+        cellPixels.assign(cellSize * cellSize, 0);
+        for (int row = 0; row < ch; row++)
+            std::copy(image.Pixels + row * w, image.Pixels + row * w + cw, cellPixels.begin() + (row + 1) * cellSize + 1);
+
+        GlState::Instance().BindTexture(GL_TEXTURE_2D_ARRAY, AtlasID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, cellSize, cellSize, 1, GL_RED, GL_UNSIGNED_BYTE, &cellPixels[0]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        character.Layer = layer;
+        character.UVMin = glm::vec2((GLfloat)(x + 1) / PageSize, (GLfloat)(y + 1) / PageSize);
+        character.UVMax = glm::vec2((GLfloat)(x + 1 + cw) / PageSize, (GLfloat)(y + 1 + ch) / PageSize);
+    }
+
+    // The atlas texture and the rasterizer are owned by exactly one Font
+    Font(const Font&);
+    Font& operator=(const Font&);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <time.h>
+#include <errno.h>
+#include <ostream>
+
+// Decides when the next frame may be presented.
+//  VSYNC      - the swap interval does the waiting, the pacer only measures
+//  TARGET_FPS - sleeps until shortly before the deadline, then spins for the last stretch
+//  UNCAPPED   - never waits, for benchmarking
+class FramePacer
+{
+public:
+    enum Mode { VSYNC, TARGET_FPS, UNCAPPED };
+
+    Mode mode;
+    double interval;    // expected seconds per frame
+    double spinMargin;  // tail of the wait that is spun instead of slept, covers scheduler wakeup latency
+
+    FramePacer(Mode mode = VSYNC, double fps = 60.0, double spinMargin = 0.002)
+        : mode(mode), interval(1.0 / fps), spinMargin(spinMargin),
+          frames(0), missed(0), started(0), deadline(0), lastFrame(0)
+    {
+    }
+
+    // Call once per frame right before swapping buffers
+    void Wait()
+    {
+        double now = Now();
+        if (frames == 0)
+        {
+            started = lastFrame = now;
+            deadline = now + interval;
+            frames++;
+            return;
+        }
+
+        if (mode == TARGET_FPS)
+        {
+            if (now > deadline)
+            {
+                // Too late already, start counting the next frame from here instead of trying to catch up
+                missed++;
+                deadline = now;
+            }
+            else
+            {
+                if (deadline - now > spinMargin)
+                    SleepUntil(deadline - spinMargin);
+                while (Now() < deadline)
+                    ;
+            }
+            deadline += interval;
+        }
+        else if (mode == VSYNC)
+        {
+            // The swap blocks on the display, a frame took too long if it spans more than one refresh
+            if (now - lastFrame > 1.5 * interval)
+                missed++;
+        }
+
+        lastFrame = Now();
+        frames++;
+    }
+
+    double MissedPercentage() const
+    {
+        return frames > 1 ? 100.0 * missed / (frames - 1) : 0.0;
+    }
+
+    void Report(std::ostream &out) const
+    {
+        static const char* names[] = { "vsync", "target fps", "uncapped" };
+        double elapsed = lastFrame - started;
+        out << "Frame pacer (" << names[mode] << "): " << frames << " frames";
+        if (elapsed > 0)
+            out << ", " << (frames - 1) / elapsed << " fps average";
+        if (mode != UNCAPPED)
+            out << ", " << missed << " missed deadlines (" << MissedPercentage() << "%)";
+        out << std::endl;
+    }
+
+private:
+    long frames, missed;
+    double started, deadline, lastFrame;
+
+    static double Now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    static void SleepUntil(double t)
+    {
+        timespec ts;
+        ts.tv_sec = (time_t)t;
+        ts.tv_nsec = (long)((t - ts.tv_sec) * 1e9);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+    }
+};
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <time.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+// Phases of a frame, in the order main() runs them
+enum FramePhase {
+    PHASE_INPUT,       // glfwPollEvents and the input callbacks
+    PHASE_CAMERA,      // panning, zooming and reshapeWindow
+    PHASE_SIMULATION,  // fixed timestep ticks: movement, collisions, scoring
+    PHASE_DRAW,        // draw submission of the world
+    PHASE_TEXT,        // HUD text
+    PHASE_PACING,      // waiting for the frame pacer deadline
+    PHASE_SWAP,        // glfwSwapBuffers
+    PHASE_COUNT
+};
+
+// Render passes measured on the GPU, see GpuTimer.h
+enum GpuPass {
+    GPU_PASS_BACKGROUND,  // full screen background quad
+    GPU_PASS_WORLD,       // pigs, floor, wood logs, bird, catapult, power bar
+    GPU_PASS_TEXT,        // HUD text
+    GPU_PASS_COUNT
+};
+
+struct FrameTiming {
+    uint64_t frame;
+    double start;                   // seconds since the profiler was created
+    double cpu[PHASE_COUNT];        // milliseconds spent in each phase
+    double total;                   // milliseconds from BeginFrame to EndFrame
+    double gpu[GPU_PASS_COUNT];     // milliseconds of GPU time per pass, -1 until the result arrives
+    unsigned glIssued, glFiltered;  // state calls that reached the driver and that GlState dropped
+};
+
+// Records CPU time per frame phase and GPU time per render pass into a fixed-size ring buffer
+// that always keeps the latest frames.
+// The render thread is the only writer. Readers may run on any thread: every slot carries a sequence
+// number that is odd while the slot is being written, so a reader can tell a torn copy from a good one.
+class FrameProfiler
+{
+public:
+    static const char* PhaseName(int phase)
+    {
+        static const char* names[PHASE_COUNT] = { "input", "camera", "simulation", "draw", "text", "pacing", "swap" };
+        return names[phase];
+    }
+
+    static const char* GpuPassName(int pass)
+    {
+        static const char* names[GPU_PASS_COUNT] = { "background", "world", "text" };
+        return names[pass];
+    }
+
+    FrameProfiler(size_t capacity = 4096)
+        : slots(capacity), written(0), epoch(Now()), frameStart(0), glIssued(0), glFiltered(0)
+    {
+        for (size_t i = 0; i < slots.size(); i++)
+            slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+
+    void BeginFrame()
+    {
+        frameStart = Now();
+        for (int i = 0; i < PHASE_COUNT; i++)
+            current[i] = 0;
+    }
+
+    // Number of the frame currently being recorded
+    uint64_t CurrentFrame() const { return written.load(std::memory_order_relaxed); }
+
+    void Begin(FramePhase phase) { phaseStart[phase] = Now(); }
+    void End(FramePhase phase) { current[phase] += (Now() - phaseStart[phase]) * 1000.0; }
+
+    // GL state calls of the frame, recorded by the next EndFrame
+    void SetGlCalls(unsigned issued, unsigned filtered)
+    {
+        glIssued = issued;
+        glFiltered = filtered;
+    }
+
+    void EndFrame()
+    {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        Slot &slot = slots[n % slots.size()];
+        slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timing.frame = n;
+        slot.timing.start = frameStart - epoch;
+        for (int i = 0; i < PHASE_COUNT; i++)
+            slot.timing.cpu[i] = current[i];
+        slot.timing.total = (Now() - frameStart) * 1000.0;
+        for (int i = 0; i < GPU_PASS_COUNT; i++)
+            slot.timing.gpu[i] = -1;
+        slot.timing.glIssued = glIssued;
+        slot.timing.glFiltered = glFiltered;
+        slot.seq.store(2 * n + 2, std::memory_order_release);
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    // GPU results arrive a frame or two late, this fills them into a frame that is already recorded
+    void SetGpuTimes(uint64_t frame, const double ms[GPU_PASS_COUNT])
+    {
+        Slot &slot = slots[frame % slots.size()];
+        if (slot.seq.load(std::memory_order_relaxed) != 2 * frame + 2)
+            return; // already recycled
+        slot.seq.store(2 * frame + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < GPU_PASS_COUNT; i++)
+            slot.timing.gpu[i] = ms[i];
+        slot.seq.store(2 * frame + 2, std::memory_order_release);
+    }
+
+    // Copies out the frames still held by the ring, oldest first
+    std::vector<FrameTiming> Snapshot() const
+    {
+        std::vector<FrameTiming> frames;
+        uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t begin = end > slots.size() ? end - slots.size() : 0;
+        for (uint64_t n = begin; n < end; n++)
+        {
+            const Slot &slot = slots[n % slots.size()];
+            uint64_t before = slot.seq.load(std::memory_order_acquire);
+            FrameTiming copy = slot.timing;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = slot.seq.load(std::memory_order_relaxed);
+            // Skip slots the writer was touching or has already recycled for a newer frame
+            if (before == after && before == 2 * n + 2)
+                frames.push_back(copy);
+        }
+        return frames;
+    }
+
+    // Writes the buffered frames to path, as JSON if it ends in ".json" and CSV otherwise
+    bool Dump(const std::string &path) const
+    {
+        std::vector<FrameTiming> frames = Snapshot();
+        std::ofstream out(path.c_str());
+        if (!out.is_open())
+        {
+            std::cout << "ERROR::PROFILER: Could not open " << path << std::endl;
+            return false;
+        }
+        bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        if (json)
+            WriteJSON(out, frames);
+        else
+            WriteCSV(out, frames);
+        std::cout << "Wrote " << frames.size() << " frame timings to " << path << std::endl;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        FrameTiming timing;
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> written;
+    double epoch, frameStart;
+    double phaseStart[PHASE_COUNT];
+    double current[PHASE_COUNT];
+    unsigned glIssued, glFiltered;
+
+    static double Now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    static void WriteCSV(std::ostream &out, const std::vector<FrameTiming> &frames)
+    {
+        out << "frame,start_s";
+        for (int i = 0; i < PHASE_COUNT; i++)
+            out << "," << PhaseName(i) << "_ms";
+        out << ",total_ms";
+        for (int i = 0; i < GPU_PASS_COUNT; i++)
+            out << ",gpu_" << GpuPassName(i) << "_ms";
+        out << ",gl_issued,gl_filtered\n";
+        for (size_t f = 0; f < frames.size(); f++)
+        {
+            out << frames[f].frame << "," << frames[f].start;
+            for (int i = 0; i < PHASE_COUNT; i++)
+                out << "," << frames[f].cpu[i];
+            out << "," << frames[f].total;
+            for (int i = 0; i < GPU_PASS_COUNT; i++)
+                out << "," << frames[f].gpu[i];
+            out << "," << frames[f].glIssued << "," << frames[f].glFiltered << "\n";
+        }
+    }
+
+    static void WriteJSON(std::ostream &out, const std::vector<FrameTiming> &frames)
+    {
+        out << "{\n  \"unit\": \"ms\",\n  \"frames\": [\n";
+        for (size_t f = 0; f < frames.size(); f++)
+        {
+            out << "    {\"frame\": " << frames[f].frame << ", \"start_s\": " << frames[f].start << ", \"cpu\": {";
+            for (int i = 0; i < PHASE_COUNT; i++)
+                out << (i ? ", " : "") << "\"" << PhaseName(i) << "\": " << frames[f].cpu[i];
+            out << "}, \"total\": " << frames[f].total << ", \"gpu\": {";
+            for (int i = 0; i < GPU_PASS_COUNT; i++)
+                out << (i ? ", " : "") << "\"" << GpuPassName(i) << "\": " << frames[f].gpu[i];
+            out << "}, \"gl_calls\": {\"issued\": " << frames[f].glIssued << ", \"filtered\": " << frames[f].glFiltered;
+            out << "}}" << (f + 1 < frames.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    FrameProfiler(const FrameProfiler&);
+    FrameProfiler& operator=(const FrameProfiler&);
+};
+
+#endif
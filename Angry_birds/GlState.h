@@ -0,0 +1,206 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <iostream>
+
+// Kinds of state calls filtered by GlState
+enum GlStateCall {
+    GL_CALL_PROGRAM,
+    GL_CALL_VERTEX_ARRAY,
+    GL_CALL_BUFFER,
+    GL_CALL_TEXTURE,
+    GL_CALL_POLYGON_MODE,
+    GL_CALL_CAPABILITY,
+    GL_CALL_BLEND_FUNC,
+    GL_CALL_KIND_COUNT
+};
+
+// Shadow copy of the GL state the game changes while drawing. Every bind and toggle goes through it,
+// and a call that would set what is already set never reaches the driver.
+// Calls are counted per frame, issued and filtered, so state churn shows up in the frame timings.
+// Textures are only tracked on unit 0, the only one the game uses. The element array buffer is part of
+// the VAO and is bound directly. Code that changes tracked state behind the cache's back must call Invalidate.
+class GlState
+{
+public:
+    static GlState& Instance()
+    {
+        static GlState state;
+        return state;
+    }
+
+    static const char* CallName(int kind)
+    {
+        static const char* names[GL_CALL_KIND_COUNT] = { "program", "vertex array", "buffer", "texture", "polygon mode",
+                                                         "enable", "blend func" };
+        return names[kind];
+    }
+
+    void UseProgram(GLuint program)
+    {
+        if (filter(GL_CALL_PROGRAM, this->program == program))
+            return;
+        glUseProgram(program);
+        this->program = program;
+    }
+
+    void BindVertexArray(GLuint vertexArray)
+    {
+        if (filter(GL_CALL_VERTEX_ARRAY, this->vertexArray == vertexArray))
+            return;
+        glBindVertexArray(vertexArray);
+        this->vertexArray = vertexArray;
+    }
+
+    // GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER and GL_DRAW_INDIRECT_BUFFER
+    void BindBuffer(GLenum target, GLuint buffer)
+    {
+        GLuint &bound = target == GL_UNIFORM_BUFFER ? uniformBuffer : target == GL_DRAW_INDIRECT_BUFFER ? indirectBuffer : arrayBuffer;
+        if (filter(GL_CALL_BUFFER, bound == buffer))
+            return;
+        glBindBuffer(target, buffer);
+        bound = buffer;
+    }
+
+    // Indexed bindings are not filtered, their ranges move every frame, but they also replace the generic binding
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+    {
+        filter(GL_CALL_BUFFER, false);
+        glBindBufferBase(target, index, buffer);
+        if (target == GL_UNIFORM_BUFFER)
+            uniformBuffer = buffer;
+    }
+
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        filter(GL_CALL_BUFFER, false);
+        glBindBufferRange(target, index, buffer, offset, size);
+        if (target == GL_UNIFORM_BUFFER)
+            uniformBuffer = buffer;
+    }
+
+    // GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY on unit 0
+    void BindTexture(GLenum target, GLuint texture)
+    {
+        GLuint &bound = target == GL_TEXTURE_2D_ARRAY ? texture2DArray : texture2D;
+        if (filter(GL_CALL_TEXTURE, bound == texture))
+            return;
+        glBindTexture(target, texture);
+        bound = texture;
+    }
+
+    void PolygonMode(GLenum mode)
+    {
+        if (filter(GL_CALL_POLYGON_MODE, polygonMode == mode))
+            return;
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        polygonMode = mode;
+    }
+
+    // GL_BLEND and GL_DEPTH_TEST
+    void Enable(GLenum cap) { setCapability(cap, true); }
+    void Disable(GLenum cap) { setCapability(cap, false); }
+
+    void BlendFunc(GLenum src, GLenum dst) { BlendFuncSeparate(src, dst, src, dst); }
+
+    void BlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+    {
+        if (filter(GL_CALL_BLEND_FUNC, blendFunc[0] == srcRGB && blendFunc[1] == dstRGB
+                                       && blendFunc[2] == srcAlpha && blendFunc[3] == dstAlpha))
+            return;
+        glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+        blendFunc[0] = srcRGB;
+        blendFunc[1] = dstRGB;
+        blendFunc[2] = srcAlpha;
+        blendFunc[3] = dstAlpha;
+    }
+
+    // Forgets everything, the next call of each kind reaches the driver
+    void Invalidate()
+    {
+        program = vertexArray = arrayBuffer = uniformBuffer = indirectBuffer = texture2D = texture2DArray = UNKNOWN;
+        polygonMode = UNKNOWN;
+        for (int i = 0; i < CAPABILITY_COUNT; i++)
+            capabilities[i] = UNKNOWN_CAPABILITY;
+        for (int i = 0; i < 4; i++)
+            blendFunc[i] = UNKNOWN;
+    }
+
+    // Closes the frame's counts, Issued and Filtered then report it until the next EndFrame
+    void EndFrame()
+    {
+        for (int i = 0; i < GL_CALL_KIND_COUNT; i++)
+        {
+            lastIssued[i] = issued[i];
+            lastFiltered[i] = filtered[i];
+            issued[i] = filtered[i] = 0;
+        }
+    }
+
+    unsigned Issued() const { return sum(lastIssued); }
+    unsigned Filtered() const { return sum(lastFiltered); }
+
+    void Report(std::ostream &out) const
+    {
+        out << "GL state calls last frame: " << Issued() << " issued, " << Filtered() << " filtered" << std::endl;
+        for (int i = 0; i < GL_CALL_KIND_COUNT; i++)
+            out << "  " << CallName(i) << ": " << lastIssued[i] << " issued, " << lastFiltered[i] << " filtered" << std::endl;
+    }
+
+private:
+    static const GLuint UNKNOWN = ~0u;
+    static const int CAPABILITY_COUNT = 2;
+    enum { UNKNOWN_CAPABILITY = -1 };
+
+    GLuint program, vertexArray, arrayBuffer, uniformBuffer, indirectBuffer, texture2D, texture2DArray;
+    GLenum polygonMode;
+    int capabilities[CAPABILITY_COUNT];   // GL_BLEND, GL_DEPTH_TEST: 1 on, 0 off
+    GLenum blendFunc[4];
+    unsigned issued[GL_CALL_KIND_COUNT], filtered[GL_CALL_KIND_COUNT];
+    unsigned lastIssued[GL_CALL_KIND_COUNT], lastFiltered[GL_CALL_KIND_COUNT];
+
+    GlState()
+    {
+        Invalidate();
+        for (int i = 0; i < GL_CALL_KIND_COUNT; i++)
+            issued[i] = filtered[i] = lastIssued[i] = lastFiltered[i] = 0;
+    }
+
+    // Counts the call and returns true when it can be dropped
+    bool filter(GlStateCall kind, bool redundant)
+    {
+        if (redundant)
+            filtered[kind]++;
+        else
+            issued[kind]++;
+        return redundant;
+    }
+
+    void setCapability(GLenum cap, bool on)
+    {
+        int index = cap == GL_BLEND ? 0 : cap == GL_DEPTH_TEST ? 1 : -1;
+        if (index < 0)
+        {
+            filter(GL_CALL_CAPABILITY, false);
+            on ? glEnable(cap) : glDisable(cap);
+            return;
+        }
+        if (filter(GL_CALL_CAPABILITY, capabilities[index] == (int)on))
+            return;
+        on ? glEnable(cap) : glDisable(cap);
+        capabilities[index] = on;
+    }
+
+    static unsigned sum(const unsigned counts[GL_CALL_KIND_COUNT])
+    {
+        unsigned total = 0;
+        for (int i = 0; i < GL_CALL_KIND_COUNT; i++)
+            total += counts[i];
+        return total;
+    }
+
+    GlState(const GlState&);
+    GlState& operator=(const GlState&);
+};
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef GLYPHRASTERIZER_H
+#define GLYPHRASTERIZER_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+enum FontMode {
+    FONT_BITMAP,  // coverage bitmaps, sharp only near the nominal size
+    FONT_SDF      // signed distance fields, one small atlas for every scale (use shaders/text_sdf.frag)
+};
+
+// One glyph as it goes into the atlas. Metrics are in atlas texels, rows run top to bottom.
+// Pixels belongs to whoever produced the image and stays valid until their next glyph.
+struct GlyphImage {
+    int Width, Height;
+    float Left, Top;     // Offset from the pen position on the baseline to the top-left texel
+    float Advance;
+    const unsigned char *Pixels;
+};
+
+// Turns code points into atlas images with FreeType, without touching OpenGL.
+// Font uses it for glyphs it has no prebaked copy of, and the asset packer uses it to bake them.
+class GlyphRasterizer
+{
+public:
+    // Texel size of SDF glyphs, how far the distance field reaches outside the outline and
+    // how much finer the outline is rasterized before the field is computed
+    static const int SDFPixelSize = 24;
+    static const int SDFSpread = 4;
+    static const int SDFOversample = 4;
+
+    // Pixels per em of the atlas images for a font requested at pixelSize
+    static int RasterSize(FontMode mode, int pixelSize) { return mode == FONT_SDF ? SDFPixelSize : pixelSize; }
+
+    GlyphRasterizer(const char* fontPath, FontMode mode, int pixelSize) : mode(mode), ft(NULL), face(NULL)
+    {
+        // All functions return a value different than 0 whenever an error occurred
+        if (FT_Init_FreeType(&ft))
+        {
+            std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+            ft = NULL;
+            return;
+        }
+        if (FT_New_Face(ft, fontPath, 0, &face))
+        {
+            std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+            face = NULL;
+            return;
+        }
+        FT_Set_Pixel_Sizes(face, 0, mode == FONT_SDF ? SDFPixelSize * SDFOversample : pixelSize);
+    }
+
+    ~GlyphRasterizer()
+    {
+        if (face)
+            FT_Done_Face(face);
+        if (ft)
+            FT_Done_FreeType(ft);
+    }
+
+    bool IsOpen() const { return face != NULL; }
+
+    // Loads the outline and renders it, image.Pixels points into this rasterizer
+    bool Rasterize(uint32_t codepoint, GlyphImage &image)
+    {
+        if (!face)
+            return false;
+        if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER))
+        {
+            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+            return false;
+        }
+        FT_Bitmap &bitmap = face->glyph->bitmap;
+        int w = bitmap.width, h = bitmap.rows;
+        float left = face->glyph->bitmap_left, top = face->glyph->bitmap_top;
+        float advance = face->glyph->advance.x / 64.0f;
+        if (mode == FONT_SDF)
+        {
+            if (w > 0 && h > 0)
+                buildDistanceField(bitmap, pixels, w, h);
+            left = left / SDFOversample - SDFSpread;
+            top = top / SDFOversample + SDFSpread;
+            advance /= SDFOversample;
+        }
+        else
+        {
+            pixels.resize(w * h);
+            for (int row = 0; row < h; row++)
+                for (int col = 0; col < w; col++)
+                    pixels[row * w + col] = bitmap.buffer[row * bitmap.pitch + col];
+        }
+        image.Width = w;
+        image.Height = h;
+        image.Left = left;
+        image.Top = top;
+        image.Advance = advance;
+        image.Pixels = pixels.empty() ? NULL : &pixels[0];
+        return true;
+    }
+
+private:
+    FontMode mode;
+    FT_Library ft;
+    FT_Face face;
+    std::vector<unsigned char> pixels;
+
+    // Squared euclidean distance transform of one row or column (Felzenszwalb & Huttenlocher)
+    static void distance1D(const float *f, float *d, int n, int *v, float *z)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -1e20f;
+        z[1] = 1e20f;
+        for (int q = 1; q < n; q++)
+        {
+            float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            while (s <= z[k])
+            {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = 1e20f;
+        }
+        k = 0;
+        for (int q = 0; q < n; q++)
+        {
+            while (z[k + 1] < q)
+                k++;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    // Squared distance from every pixel to the nearest pixel where grid is 0
+    static void distanceTransform(std::vector<float> &grid, int w, int h)
+    {
+        int n = std::max(w, h);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int x = 0; x < w; x++)
+        {
+            for (int y = 0; y < h; y++)
+                f[y] = grid[y * w + x];
+            distance1D(&f[0], &d[0], h, &v[0], &z[0]);
+            for (int y = 0; y < h; y++)
+                grid[y * w + x] = d[y];
+        }
+        for (int y = 0; y < h; y++)
+        {
+            distance1D(&grid[y * w], &d[0], w, &v[0], &z[0]);
+            std::copy(d.begin(), d.begin() + w, grid.begin() + y * w);
+        }
+    }
+
+    // Turns an oversampled coverage bitmap into a padded SDF glyph at 1/SDFOversample resolution.
+    // 128 is the outline, values grow inside the glyph and reach 0 or 255 SDFSpread texels away from it.
+    static void buildDistanceField(const FT_Bitmap &bitmap, std::vector<unsigned char> &out, int &w, int &h)
+    {
+        const float INF = 1e20f;
+        int pad = SDFSpread * SDFOversample;
+        int hw = bitmap.width + 2 * pad, hh = bitmap.rows + 2 * pad;
+        std::vector<float> outside(hw * hh), inside(hw * hh);
+        for (int y = 0; y < hh; y++)
+            for (int x = 0; x < hw; x++)
+            {
+                int bx = x - pad, by = y - pad;
+                bool in = bx >= 0 && by >= 0 && bx < (int)bitmap.width && by < (int)bitmap.rows && bitmap.buffer[by * bitmap.pitch + bx] >= 128;
+                outside[y * hw + x] = in ? 0 : INF;
+                inside[y * hw + x] = in ? INF : 0;
+            }
+        distanceTransform(outside, hw, hh);
+        distanceTransform(inside, hw, hh);
+
+        w = (hw + SDFOversample - 1) / SDFOversample;
+        h = (hh + SDFOversample - 1) / SDFOversample;
+        out.resize(w * h);
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+            {
+                // Sample the fine grid at the center of each coarse texel
+                int sx = std::min(x * SDFOversample + SDFOversample / 2, hw - 1);
+                int sy = std::min(y * SDFOversample + SDFOversample / 2, hh - 1);
+                float dist = (std::sqrt(inside[sy * hw + sx]) - std::sqrt(outside[sy * hw + sx])) / SDFOversample;
+                float value = 0.5f + dist / (2.0f * SDFSpread);
+                out[y * w + x] = (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+            }
+    }
+
+    // The FreeType face is owned by exactly one rasterizer
+    GlyphRasterizer(const GlyphRasterizer&);
+    GlyphRasterizer& operator=(const GlyphRasterizer&);
+};
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef GPURESOURCE_H
+#define GPURESOURCE_H
+
+#include <stddef.h>
+#include <iostream>
+
+#include "GlState.h"
+
+enum GpuResourceKind {
+    GPU_BUFFER,
+    GPU_VERTEX_ARRAY,
+    GPU_TEXTURE,
+    GPU_FRAMEBUFFER,
+    GPU_PROGRAM,
+    GPU_QUERY,
+    GPU_KIND_COUNT
+};
+
+// Counts every GL object created through GpuHandle and the memory behind it, by kind.
+// Byte totals are what the owners declare with SetBytes (buffer sizes exactly, textures as width x height
+// x texel size), so they track our allocations rather than the driver's padding.
+// Live counts and bytes that stay level while Created keeps growing mean objects are recycled, not leaked.
+class GpuRegistry
+{
+public:
+    static GpuRegistry& Instance()
+    {
+        static GpuRegistry registry;
+        return registry;
+    }
+
+    static const char* KindName(int kind)
+    {
+        static const char* names[GPU_KIND_COUNT] = { "buffers", "vertex arrays", "textures", "framebuffers", "programs", "queries" };
+        return names[kind];
+    }
+
+    void Created(GpuResourceKind kind) { live[kind]++; created[kind]++; }
+    void Destroyed(GpuResourceKind kind) { live[kind]--; }
+
+    void Resized(GpuResourceKind kind, size_t from, size_t to)
+    {
+        bytes[kind] += to - from;
+        if (bytes[kind] > peak[kind])
+            peak[kind] = bytes[kind];
+    }
+
+    size_t Live(int kind) const { return live[kind]; }
+    size_t Bytes(int kind) const { return bytes[kind]; }
+
+    size_t TotalLive() const
+    {
+        size_t total = 0;
+        for (int i = 0; i < GPU_KIND_COUNT; i++)
+            total += live[i];
+        return total;
+    }
+
+    size_t TotalBytes() const
+    {
+        size_t total = 0;
+        for (int i = 0; i < GPU_KIND_COUNT; i++)
+            total += bytes[i];
+        return total;
+    }
+
+    void Report(std::ostream &out) const
+    {
+        out << "GPU objects: " << TotalLive() << " live, " << TotalBytes() / 1024.0 << " KiB" << std::endl;
+        for (int i = 0; i < GPU_KIND_COUNT; i++)
+            out << "  " << KindName(i) << ": " << live[i] << " live (" << created[i] << " created), "
+                << bytes[i] / 1024.0 << " KiB (peak " << peak[i] / 1024.0 << " KiB)" << std::endl;
+    }
+
+private:
+    size_t live[GPU_KIND_COUNT], created[GPU_KIND_COUNT];
+    size_t bytes[GPU_KIND_COUNT], peak[GPU_KIND_COUNT];
+
+    GpuRegistry()
+    {
+        for (int i = 0; i < GPU_KIND_COUNT; i++)
+            live[i] = created[i] = bytes[i] = peak[i] = 0;
+    }
+};
+
+// How each kind of object is created and deleted
+template <GpuResourceKind Kind> struct GpuObjectTraits;
+
+template <> struct GpuObjectTraits<GPU_BUFFER> {
+    static GLuint Create() { GLuint id; glGenBuffers(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteBuffers(1, &id); }
+};
+template <> struct GpuObjectTraits<GPU_VERTEX_ARRAY> {
+    static GLuint Create() { GLuint id; glGenVertexArrays(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+};
+template <> struct GpuObjectTraits<GPU_TEXTURE> {
+    static GLuint Create() { GLuint id; glGenTextures(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteTextures(1, &id); }
+};
+template <> struct GpuObjectTraits<GPU_FRAMEBUFFER> {
+    static GLuint Create() { GLuint id; glGenFramebuffers(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteFramebuffers(1, &id); }
+};
+template <> struct GpuObjectTraits<GPU_PROGRAM> {
+    static GLuint Create() { return glCreateProgram(); }
+    static void Destroy(GLuint id) { glDeleteProgram(id); }
+};
+template <> struct GpuObjectTraits<GPU_QUERY> {
+    static GLuint Create() { GLuint id; glGenQueries(1, &id); return id; }
+    static void Destroy(GLuint id) { glDeleteQueries(1, &id); }
+};
+
+// Owns one GL object name: deleted with the handle, movable but not copyable.
+// Converts to GLuint so it can be passed straight to GL calls.
+// Handles must be released while the context is still current, so owners that live until exit
+// are reset explicitly before the window is destroyed.
+template <GpuResourceKind Kind>
+class GpuHandle
+{
+public:
+    GpuHandle() : id(0), bytes(0) {}
+
+    // Takes ownership of a name created elsewhere
+    explicit GpuHandle(GLuint adopt) : id(adopt), bytes(0)
+    {
+        if (id)
+            GpuRegistry::Instance().Created(Kind);
+    }
+
+    static GpuHandle Create() { return GpuHandle(GpuObjectTraits<Kind>::Create()); }
+
+    GpuHandle(GpuHandle &&other) : id(other.id), bytes(other.bytes)
+    {
+        other.id = 0;
+        other.bytes = 0;
+    }
+
+    GpuHandle& operator=(GpuHandle &&other)
+    {
+        if (this != &other)
+        {
+            Reset();
+            id = other.id;
+            bytes = other.bytes;
+            other.id = 0;
+            other.bytes = 0;
+        }
+        return *this;
+    }
+
+    ~GpuHandle() { Reset(); }
+
+    operator GLuint() const { return id; }
+
+    // Memory held by the object, for the registry
+    void SetBytes(size_t size)
+    {
+        GpuRegistry::Instance().Resized(Kind, bytes, size);
+        bytes = size;
+    }
+
+    // glBufferData on the buffer bound to target (which must be this one), with the size recorded
+    void Data(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+    {
+        glBufferData(target, size, data, usage);
+        SetBytes(size);
+    }
+
+    void Reset()
+    {
+        if (!id)
+            return;
+        SetBytes(0);
+        GpuObjectTraits<Kind>::Destroy(id);
+        GpuRegistry::Instance().Destroyed(Kind);
+        // The name may come back from the next glGen*, bindings the state cache remembers can't be trusted
+        GlState::Instance().Invalidate();
+        id = 0;
+    }
+
+private:
+    GLuint id;
+    size_t bytes;
+
+    GpuHandle(const GpuHandle&);
+    GpuHandle& operator=(const GpuHandle&);
+};
+
+typedef GpuHandle<GPU_BUFFER> GpuBuffer;
+typedef GpuHandle<GPU_VERTEX_ARRAY> GpuVertexArray;
+typedef GpuHandle<GPU_TEXTURE> GpuTexture;
+typedef GpuHandle<GPU_FRAMEBUFFER> GpuFramebuffer;
+typedef GpuHandle<GPU_PROGRAM> GpuProgram;
+typedef GpuHandle<GPU_QUERY> GpuQuery;
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include "FrameProfiler.h"
+#include "GpuResource.h"
+
+// Query sets in flight, a result normally arrives within two or three frames
+const int GPU_TIMER_SETS = 4;
+
+// Measures GPU time of each render pass with GL_TIME_ELAPSED queries.
+// Queries rotate through a ring of sets: each frame records into the next set while the older ones are
+// in flight. A set stays pending until the driver reports every result available, and is only read then,
+// so the CPU does not wait on the GPU. Only when the ring comes round to a set that is still pending,
+// with the GPU GPU_TIMER_SETS frames behind, are its results waited for, so no frame loses its timings.
+class GpuTimer
+{
+public:
+    GpuTimer() : current(0)
+    {
+        for (int set = 0; set < GPU_TIMER_SETS; set++)
+        {
+            pending[set] = false;
+            for (int pass = 0; pass < GPU_PASS_COUNT; pass++)
+            {
+                queries[set][pass] = GpuQuery::Create();
+                used[set][pass] = false;
+            }
+        }
+    }
+
+    // Collects every set whose results are ready, then starts recording this frame into the next one
+    void BeginFrame(FrameProfiler &profiler)
+    {
+        for (int i = 1; i <= GPU_TIMER_SETS; i++)
+            Collect(profiler, (current + i) % GPU_TIMER_SETS, false);
+        current = (current + 1) % GPU_TIMER_SETS;
+        Collect(profiler, current, true);
+        frame[current] = profiler.CurrentFrame();
+        pending[current] = true;
+        for (int pass = 0; pass < GPU_PASS_COUNT; pass++)
+            used[current][pass] = false;
+    }
+
+    // Passes may not overlap, GL allows only one active GL_TIME_ELAPSED query at a time
+    void Begin(GpuPass pass)
+    {
+        glBeginQuery(GL_TIME_ELAPSED, queries[current][pass]);
+        used[current][pass] = true;
+    }
+
+    void End(GpuPass)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+private:
+    GpuQuery queries[GPU_TIMER_SETS][GPU_PASS_COUNT];
+    bool used[GPU_TIMER_SETS][GPU_PASS_COUNT];
+    bool pending[GPU_TIMER_SETS];
+    uint64_t frame[GPU_TIMER_SETS];
+    int current;
+
+    // Hands the set's results to the profiler once all of them are available, or waits for them if wait is set
+    void Collect(FrameProfiler &profiler, int set, bool wait)
+    {
+        if (!pending[set])
+            return;
+        for (int pass = 0; pass < GPU_PASS_COUNT && !wait; pass++)
+        {
+            if (!used[set][pass])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[set][pass], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+        }
+        pending[set] = false;
+
+        double ms[GPU_PASS_COUNT];
+        for (int pass = 0; pass < GPU_PASS_COUNT; pass++)
+        {
+            ms[pass] = -1;
+            if (!used[set][pass])
+                continue;
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[set][pass], GL_QUERY_RESULT, &elapsed);
+            ms[pass] = elapsed / 1e6;
+        }
+        profiler.SetGpuTimes(frame[set], ms);
+    }
+
+    GpuTimer(const GpuTimer&);
+    GpuTimer& operator=(const GpuTimer&);
+};
+
+#endif
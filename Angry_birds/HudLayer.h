@@ -0,0 +1,113 @@
+#ifndef HUDLAYER_H
+#define HUDLAYER_H
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include "GpuResource.h"
+
+// Past this density the HUD text is sharp enough, more texels only cost memory
+const GLfloat HUD_MAX_PIXELS_PER_UNIT = 4.0f;
+
+// Offscreen layer for HUD elements that rarely change.
+// The HUD is drawn into a texture only when it is invalidated; every other frame the texture is
+// composited with a single quad. The texture holds premultiplied alpha, blend it with
+// BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+class HudLayer
+{
+public:
+    GpuTexture TextureID;
+    GpuFramebuffer FramebufferID;
+    GLsizei Width, Height;
+    glm::mat4 Projection;   // maps the layer's rectangle onto the whole texture
+
+    // The layer covers [left,right]x[bottom,top] in the units the HUD is laid out in, at pixelsPerUnit
+    // texels per unit. Keep that at the framebuffer's density with SetPixelsPerUnit so it stays sharp when the camera zooms.
+    HudLayer(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat pixelsPerUnit = 2.0f)
+        : Width(0), Height(0), unitsWide(right - left), unitsHigh(top - bottom), dirty(true)
+    {
+        GLint maxSize = 4096;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        maxTextureSize = (GLfloat)maxSize;
+        Projection = glm::ortho(left, right, bottom, top);
+
+        TextureID = GpuTexture::Create();
+        GlState::Instance().BindTexture(GL_TEXTURE_2D, TextureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        SetPixelsPerUnit(pixelsPerUnit);
+
+        FramebufferID = GpuFramebuffer::Create();
+        glBindFramebuffer(GL_FRAMEBUFFER, FramebufferID);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, TextureID, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::HUD: Framebuffer is not complete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Resizes the texture when the density changes, the same texture object keeps its framebuffer and its
+    // users, only the contents are stale. The density is rounded up to a step of a half power of two, so
+    // zooming reallocates the texture every few steps rather than every frame, and capped at what the
+    // texture size limit allows however far the camera zooms in.
+    void SetPixelsPerUnit(GLfloat pixelsPerUnit)
+    {
+        GLfloat density = std::pow(2.0f, std::ceil(std::log2(std::max(pixelsPerUnit, 0.25f)) * 2) / 2);
+        density = std::min(density, std::min(HUD_MAX_PIXELS_PER_UNIT, maxTextureSize / std::max(unitsWide, unitsHigh)));
+        GLsizei width = std::max((GLsizei)(unitsWide * density + 0.5f), 1);
+        GLsizei height = std::max((GLsizei)(unitsHigh * density + 0.5f), 1);
+        if (width == Width && height == Height)
+            return;
+        Width = width;
+        Height = height;
+        GlState::Instance().BindTexture(GL_TEXTURE_2D, TextureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, Width, Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        TextureID.SetBytes((size_t)Width * Height * 4);
+        dirty = true;
+    }
+
+    // Marks the contents stale, the next NeedsRedraw() returns true
+    void Invalidate() { dirty = true; }
+    bool NeedsRedraw() const { return dirty; }
+
+    // Redirects rendering into the layer and clears it to transparent
+    void BeginRedraw()
+    {
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, savedClearColor);
+        glBindFramebuffer(GL_FRAMEBUFFER, FramebufferID);
+        glViewport(0, 0, Width, Height);
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        GlState &gl = GlState::Instance();
+        gl.Disable(GL_DEPTH_TEST);
+        gl.Enable(GL_BLEND);
+        // Color ends up premultiplied by coverage while alpha keeps the plain coverage
+        gl.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // Back to the window framebuffer with the state BeginRedraw changed restored
+    void EndRedraw()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+        glClearColor(savedClearColor[0], savedClearColor[1], savedClearColor[2], savedClearColor[3]);
+        GlState::Instance().Enable(GL_DEPTH_TEST);
+        GlState::Instance().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        dirty = false;
+    }
+
+private:
+    GLfloat unitsWide, unitsHigh;
+    GLfloat maxTextureSize;
+    bool dirty;
+    GLint savedViewport[4];
+    GLfloat savedClearColor[4];
+
+    HudLayer(const HudLayer&);
+    HudLayer& operator=(const HudLayer&);
+};
+
+#endif
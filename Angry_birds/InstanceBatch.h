@@ -0,0 +1,82 @@
+#ifndef INSTANCEBATCH_H
+#define INSTANCEBATCH_H
+
+#include <vector>
+#include <cstddef>
+
+#include "MeshArena.h"
+#include "StreamBuffer.h"
+
+// Placement of one instance: the unit mesh is scaled, rotated by angle (radians) around its origin,
+// then moved to (x, y). The mesh colors are multiplied by the tint.
+struct InstanceData {
+    GLfloat x, y, angle;
+    GLfloat scalex, scaley;
+    GLubyte r, g, b, a;
+};
+
+// Draws many copies of one arena mesh with a single instanced draw call (shader: Instanced_GL.vert).
+// Instances are collected every frame and written to the stream buffer, the same way TextBatch streams
+// glyph quads. The VAO reads the mesh from the arena's buffers, so the arena must be uploaded first.
+// Drawing leaves the batch's VAO bound.
+class InstanceBatch
+{
+public:
+    InstanceBatch(const MeshArena &arena, StreamBuffer &stream, MeshRange mesh, GLsizei maxInstances = 64)
+        : stream(stream), mesh(mesh)
+    {
+        VAO = GpuVertexArray::Create();
+        GlState::Instance().BindVertexArray(VAO);
+        arena.SetVertexFormat();
+        // Attribute 2 - x, y, angle; 3 - scale; 4 - tint. They point into the stream buffer once drawn.
+        for (GLuint attribute = 2; attribute <= 4; attribute++)
+        {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+        instances.reserve(maxInstances);
+    }
+
+    void Add(GLfloat x, GLfloat y, GLfloat angle, GLfloat scalex, GLfloat scaley, glm::vec3 tint = glm::vec3(1, 1, 1))
+    {
+        InstanceData instance;
+        instance.x = x;
+        instance.y = y;
+        instance.angle = angle;
+        instance.scalex = scalex;
+        instance.scaley = scaley;
+        instance.r = ColorVertex::unorm(tint.x);
+        instance.g = ColorVertex::unorm(tint.y);
+        instance.b = ColorVertex::unorm(tint.z);
+        instance.a = 255;
+        instances.push_back(instance);
+    }
+
+    // Uploads the instances added since the last call and draws them all, the instanced program must be in use
+    void Draw(GLenum mode = GL_TRIANGLES)
+    {
+        GLsizei count = instances.size();
+        if (count == 0)
+            return;
+
+        GLintptr offset = stream.Write(&instances[0], count * sizeof(InstanceData), sizeof(InstanceData));
+        GlState::Instance().BindVertexArray(VAO);
+        GlState::Instance().BindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, x)));
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, scalex)));
+        glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, r)));
+        glDrawElementsInstancedBaseVertex(mode, mesh.NumIndices, GL_UNSIGNED_INT, (void*)(mesh.FirstIndex * sizeof(GLuint)), count, mesh.BaseVertex);
+        instances.clear();
+    }
+
+private:
+    StreamBuffer &stream;
+    MeshRange mesh;
+    GpuVertexArray VAO;
+    std::vector<InstanceData> instances;
+
+    InstanceBatch(const InstanceBatch&);
+    InstanceBatch& operator=(const InstanceBatch&);
+};
+
+#endif
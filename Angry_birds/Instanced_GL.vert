@@ -0,0 +1,32 @@
+#version 330 core
+
+// input data : sent from main program
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 1) in vec4 vertexColor;   // normalized from 8 bits per channel
+
+// per instance, see InstanceBatch.h
+layout (location = 2) in vec3 instanceTransform; // x, y, rotation in radians
+layout (location = 3) in vec2 instanceScale;
+layout (location = 4) in vec4 instanceTint;
+
+// shared by every world program, see UniformBlocks.h
+layout (std140) uniform Camera {
+    mat4 VP;
+    float PixelSize;  // world units per framebuffer pixel
+};
+
+// output data : used by fragment shader
+out vec3 fragColor;
+
+void main ()
+{
+    // Scale, rotate around the mesh origin, then move into place
+    vec2 p = vertexPosition * instanceScale;
+    float c = cos(instanceTransform.z), s = sin(instanceTransform.z);
+    p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + instanceTransform.xy;
+
+    fragColor = vertexColor.rgb * instanceTint.rgb;
+
+    // Output position of the vertex, in clip space : VP * position
+    gl_Position = VP * vec4(p, 0, 1);
+}
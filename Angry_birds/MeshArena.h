@@ -0,0 +1,138 @@
+#ifndef MESHARENA_H
+#define MESHARENA_H
+
+#include <vector>
+#include <cstddef>
+
+#include "MeshBuilder.h"
+#include "GpuResource.h"
+
+// Texture coordinates of one vertex, a stream of its own next to the ColorVertex data
+struct TexCoord {
+    GLfloat s, t;
+};
+
+// Where one mesh lives inside a MeshArena
+struct MeshRange {
+    GLint BaseVertex;       // added to every index of the mesh
+    GLsizei FirstIndex;
+    GLsizei NumIndices;
+};
+
+// One draw of glMultiDrawElementsIndirect, laid out as GL reads it from the indirect buffer
+struct DrawElementsCommand {
+    GLuint Count;
+    GLuint InstanceCount;
+    GLuint FirstIndex;
+    GLint BaseVertex;
+    GLuint BaseInstance;
+};
+
+// Every static mesh of the game in one vertex buffer and one index buffer behind a single VAO.
+// Meshes are appended on the CPU while the level is built and uploaded together; afterwards a mesh is
+// only an index range, and drawing any number of them needs one VAO bind.
+// Indices stay local to their mesh and are rebased with glDrawElementsBaseVertex.
+// Textured meshes also give float texture coordinates, which go to a parallel buffer; other meshes get zeros there.
+class MeshArena
+{
+public:
+    GpuVertexArray VertexArrayID;
+    GpuBuffer VertexBuffer, TexCoordBuffer, IndexBuffer;
+
+    MeshArena() {}
+
+    MeshRange Add(const ColorVertex *vertices, GLsizei numVertices, const GLuint *indices, GLsizei numIndices,
+                  const TexCoord *texCoords = NULL)
+    {
+        MeshRange range;
+        range.BaseVertex = this->vertices.size();
+        range.FirstIndex = this->indices.size();
+        range.NumIndices = numIndices;
+        this->vertices.insert(this->vertices.end(), vertices, vertices + numVertices);
+        if (texCoords)
+            this->texCoords.insert(this->texCoords.end(), texCoords, texCoords + numVertices);
+        else
+            this->texCoords.resize(this->vertices.size(), TexCoord());
+        this->indices.insert(this->indices.end(), indices, indices + numIndices);
+        return range;
+    }
+
+    // Sends everything added so far to the GPU, call again if meshes are added later
+    void Upload()
+    {
+        GlState &gl = GlState::Instance();
+        if (!VertexArrayID)
+        {
+            VertexArrayID = GpuVertexArray::Create();
+            VertexBuffer = GpuBuffer::Create();
+            TexCoordBuffer = GpuBuffer::Create();
+            IndexBuffer = GpuBuffer::Create();
+            Bind();
+            SetVertexFormat();
+        }
+        else
+            Bind();
+        gl.BindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+        VertexBuffer.Data(GL_ARRAY_BUFFER, vertices.size() * sizeof(ColorVertex), &vertices[0], GL_STATIC_DRAW);
+        gl.BindBuffer(GL_ARRAY_BUFFER, TexCoordBuffer);
+        TexCoordBuffer.Data(GL_ARRAY_BUFFER, texCoords.size() * sizeof(TexCoord), &texCoords[0], GL_STATIC_DRAW);
+        IndexBuffer.Data(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    }
+
+    // Points attributes 0, 1 and 6 and the element buffer of the bound VAO at the arena.
+    // Other VAOs that draw arena meshes, such as InstanceBatch, share the layout this way.
+    void SetVertexFormat() const
+    {
+        GlState::Instance().BindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+        // Attribute 0 - 2d position
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ColorVertex), (void*)offsetof(ColorVertex, x));
+        // Attribute 1 - color
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ColorVertex), (void*)offsetof(ColorVertex, r));
+        // Attribute 6 - texture coordinates, after the instance and draw index attributes
+        GlState::Instance().BindBuffer(GL_ARRAY_BUFFER, TexCoordBuffer);
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(TexCoord), (void*)0);
+        // The element buffer binding is part of the VAO
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBuffer);
+    }
+
+    // Once per pass, every Draw after it reads from the arena
+    void Bind() const { GlState::Instance().BindVertexArray(VertexArrayID); }
+
+    void Draw(GLenum mode, const MeshRange &range) const
+    {
+        glDrawElementsBaseVertex(mode, range.NumIndices, GL_UNSIGNED_INT, (void*)(range.FirstIndex * sizeof(GLuint)), range.BaseVertex);
+    }
+
+    // A single instance whose instanced attributes are read at baseInstance, needs GL 4.2
+    void DrawBaseInstance(GLenum mode, const MeshRange &range, GLuint baseInstance) const
+    {
+        glDrawElementsInstancedBaseVertexBaseInstance(mode, range.NumIndices, GL_UNSIGNED_INT, (void*)(range.FirstIndex * sizeof(GLuint)),
+                                                      1, range.BaseVertex, baseInstance);
+    }
+
+    // The same draw as a command for MultiDraw
+    static DrawElementsCommand Command(const MeshRange &range, GLuint baseInstance)
+    {
+        DrawElementsCommand command = { (GLuint)range.NumIndices, 1, (GLuint)range.FirstIndex, range.BaseVertex, baseInstance };
+        return command;
+    }
+
+    // count commands from the bound GL_DRAW_INDIRECT_BUFFER starting at offset in one call, needs GL 4.3
+    void MultiDraw(GLenum mode, GLintptr offset, GLsizei count) const
+    {
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (void*)offset, count, 0);
+    }
+
+private:
+    std::vector<ColorVertex> vertices;
+    std::vector<TexCoord> texCoords;
+    std::vector<GLuint> indices;
+
+    MeshArena(const MeshArena&);
+    MeshArena& operator=(const MeshArena&);
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef MESHBUILDER_H
+#define MESHBUILDER_H
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+// Vertex of the color pipeline (Sample_GL.vert): 2D position and normalized 8-bit RGBA, 12 bytes.
+// z is always 0 in this game and 8 bits per channel is all the framebuffer keeps anyway.
+struct ColorVertex {
+    GLfloat x, y;
+    GLubyte r, g, b, a;
+
+    constexpr ColorVertex() : x(0), y(0), r(0), g(0), b(0), a(0) {}
+    constexpr ColorVertex(GLfloat x, GLfloat y, GLubyte r, GLubyte g, GLubyte b, GLubyte a = 255) : x(x), y(y), r(r), g(g), b(b), a(a) {}
+    // Components outside [0,1] are clamped, the same as the framebuffer would
+    ColorVertex(GLfloat x, GLfloat y, const glm::vec3 &color) : x(x), y(y), r(unorm(color.x)), g(unorm(color.y)), b(unorm(color.z)), a(255) {}
+
+    static GLubyte unorm(GLfloat c) { return (GLubyte)(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f); }
+};
+
+// Builds one indexed triangle mesh out of simple filled shapes, each with its own color.
+// Shapes are appended in order, so later ones are drawn over earlier ones.
+// Vertices with the same position and color are stored once, a circle costs its center and rim
+// instead of three vertices per triangle.
+// The output matches create3DObject: one ColorVertex per vertex, 3 indices per triangle.
+class MeshBuilder
+{
+public:
+    std::vector<ColorVertex> Vertices;
+    std::vector<GLuint> Indices;
+
+    // Color from 0-255 components
+    static glm::vec3 RGB(int r, int g, int b) { return glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f); }
+
+    GLsizei NumVertices() const { return Vertices.size(); }
+    GLsizei NumIndices() const { return Indices.size(); }
+
+    // Filled ellipse centered at (cx, cy) with radii rx, ry, as a fan of `segments` triangles
+    MeshBuilder& Ellipse(GLfloat cx, GLfloat cy, GLfloat rx, GLfloat ry, int segments, glm::vec3 color)
+    {
+        const std::vector<GLfloat> &table = unitCircle(segments);
+        GLuint center = vertex(cx, cy, color);
+        GLuint first = vertex(cx + rx * table[0], cy + ry * table[1], color), previous = first;
+        for (int i = 1; i <= segments; i++)
+        {
+            GLuint next = i < segments ? vertex(cx + rx * table[2 * i], cy + ry * table[2 * i + 1], color) : first;
+            triangle(center, previous, next);
+            previous = next;
+        }
+        return *this;
+    }
+
+    MeshBuilder& Circle(GLfloat cx, GLfloat cy, GLfloat r, int segments, glm::vec3 color)
+    {
+        return Ellipse(cx, cy, r, r, segments, color);
+    }
+
+    // Axis aligned rectangle between (x0, y0) and (x1, y1)
+    MeshBuilder& Quad(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, glm::vec3 color)
+    {
+        GLuint a = vertex(x0, y0, color), b = vertex(x1, y0, color);
+        GLuint c = vertex(x0, y1, color), d = vertex(x1, y1, color);
+        triangle(a, b, c);
+        triangle(b, c, d);
+        return *this;
+    }
+
+    MeshBuilder& Triangle(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2, glm::vec3 color)
+    {
+        triangle(vertex(x0, y0, color), vertex(x1, y1, color), vertex(x2, y2, color));
+        return *this;
+    }
+
+private:
+    // cos/sin of the fan corners, computed once per segment count and shared by every mesh
+    static const std::vector<GLfloat>& unitCircle(int segments)
+    {
+        static std::map< int, std::vector<GLfloat> > tables;
+        std::vector<GLfloat> &table = tables[segments];
+        if (table.empty())
+        {
+            table.resize(2 * segments);
+            for (int i = 0; i < segments; i++)
+            {
+                double angle = 2 * M_PI * i / segments;
+                table[2 * i] = cos(angle);
+                table[2 * i + 1] = sin(angle);
+            }
+        }
+        return table;
+    }
+
+    // Position and packed RGBA of every vertex added so far
+    typedef std::pair< std::pair<GLfloat, GLfloat>, GLuint > VertexKey;
+    std::map<VertexKey, GLuint> unique;
+
+    // Index of the vertex, added only if no identical one exists yet
+    GLuint vertex(GLfloat x, GLfloat y, const glm::vec3 &color)
+    {
+        ColorVertex v(x, y, color);
+        VertexKey key(std::make_pair(x, y), (GLuint)v.r << 24 | (GLuint)v.g << 16 | (GLuint)v.b << 8 | v.a);
+        std::map<VertexKey, GLuint>::iterator it = unique.find(key);
+        if (it != unique.end())
+            return it->second;
+        GLuint index = NumVertices();
+        unique[key] = index;
+        Vertices.push_back(v);
+        return index;
+    }
+
+    void triangle(GLuint a, GLuint b, GLuint c)
+    {
+        Indices.push_back(a);
+        Indices.push_back(b);
+        Indices.push_back(c);
+    }
+};
+
+#endif
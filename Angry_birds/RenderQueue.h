@@ -0,0 +1,206 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdint.h>
+
+#include "MeshArena.h"
+#include "UniformBlocks.h"
+#include "StreamBuffer.h"
+
+// One thing to draw: either a mesh of the arena with its own model matrix, or a batch that issues its
+// own draw calls (instanced pigs, shapes) once its program is in use
+struct DrawItem {
+    uint64_t Key;
+    GLuint Program;
+    GLuint Texture;                  // GL_TEXTURE_2D on unit 0, 0 for none
+    GLenum PrimitiveMode, FillMode;
+    MeshRange Range;
+    glm::mat4 Model;
+    std::function<void()> Batch;     // set for batch items
+};
+
+// Draw items are submitted in any order and drawn sorted by layer, then program, texture, fill mode
+// and mesh. Layers are drawn back to front, so items that overlap must be in different layers; within
+// a layer only state decides the order, and items with the same state keep their submission order.
+// Program, texture, VAO and polygon mode are set through GlState, which drops what is already set,
+// so with this order state changes grow with the number of materials rather than objects.
+//
+// Model matrices of a flush are written to the stream buffer in one go and bound as the Transforms
+// block. The range bound covers the whole block but only the matrices in use are copied, the rest of
+// it is whatever the stream holds there and no draw index reaches it. Each draw finds its matrix through
+// the drawIndex attribute: with GL 4.2 it is an instanced attribute read at the draw's base instance,
+// before that it is a constant attribute value set per draw, which is still cheaper than a matrix uniform.
+//
+// With GL 4.3 a flush writes one indirect command per mesh next to the matrices, and every run of meshes
+// with the same state is a single glMultiDrawElementsIndirect, so the number of calls no longer grows
+// with the objects of a level. The command's base instance carries the draw index; that is what
+// gl_DrawID would give, but it needs GLSL 4.60 and the shaders are 3.30.
+class RenderQueue
+{
+public:
+    RenderQueue(const MeshArena &arena, StreamBuffer &stream)
+        : arena(arena), stream(stream), baseInstance(GLAD_GL_VERSION_4_2), multiDraw(GLAD_GL_VERSION_4_3)
+    {
+        GlState &gl = GlState::Instance();
+        if (baseInstance)
+        {
+            // 0, 1, 2, ... one per instance, so instance number baseInstance reads the draw index
+            std::vector<GLint> indices(MAX_DRAW_TRANSFORMS);
+            for (int i = 0; i < MAX_DRAW_TRANSFORMS; i++)
+                indices[i] = i;
+            DrawIndexBuffer = GpuBuffer::Create();
+            arena.Bind();
+            gl.BindBuffer(GL_ARRAY_BUFFER, DrawIndexBuffer);
+            DrawIndexBuffer.Data(GL_ARRAY_BUFFER, indices.size() * sizeof(GLint), &indices[0], GL_STATIC_DRAW);
+            glEnableVertexAttribArray(DRAW_INDEX_ATTRIBUTE);
+            glVertexAttribIPointer(DRAW_INDEX_ATTRIBUTE, 1, GL_INT, sizeof(GLint), (void*)0);
+            glVertexAttribDivisor(DRAW_INDEX_ATTRIBUTE, 1);
+        }
+    }
+
+    void Submit(int layer, GLuint program, const glm::mat4 &model, GLenum primitiveMode, const MeshRange &range,
+                GLenum fillMode = GL_FILL, GLuint texture = 0)
+    {
+        DrawItem item;
+        item.Key = key(layer, program, texture, fillMode, range.FirstIndex);
+        item.Program = program;
+        item.Texture = texture;
+        item.PrimitiveMode = primitiveMode;
+        item.FillMode = fillMode;
+        item.Range = range;
+        item.Model = model;
+        items.push_back(item);
+    }
+
+    // The batch sets its own uniforms and draws, after the meshes of the same layer and program
+    void SubmitBatch(int layer, GLuint program, const std::function<void()> &batch)
+    {
+        DrawItem item;
+        item.Key = key(layer, program, 0, GL_FILL, MeshIndexMask);
+        item.Program = program;
+        item.Batch = batch;
+        items.push_back(item);
+    }
+
+    // Draws everything submitted since the last flush
+    void Flush()
+    {
+        std::stable_sort(items.begin(), items.end(), byKey);
+        // Transforms holds MAX_DRAW_TRANSFORMS matrices, more draws than that are flushed in parts
+        for (size_t begin = 0; begin < items.size(); )
+        {
+            size_t end = begin;
+            transforms.clear();
+            for (; end < items.size() && transforms.size() < (size_t)MAX_DRAW_TRANSFORMS; end++)
+                if (!items[end].Batch)
+                    transforms.push_back(items[end].Model);
+            if (!transforms.empty())
+            {
+                GLsizeiptr size = MAX_DRAW_TRANSFORMS * sizeof(glm::mat4);
+                GLintptr offset = stream.Write(&transforms[0], transforms.size() * sizeof(glm::mat4), stream.UniformAlignment(), size);
+                GlState::Instance().BindBufferRange(GL_UNIFORM_BUFFER, TRANSFORMS_BINDING, stream.Buffer, offset, size);
+            }
+
+            if (multiDraw)
+                drawRuns(begin, end);
+            else
+            {
+                GLint drawIndex = 0;
+                for (size_t i = begin; i < end; i++)
+                    draw(items[i], items[i].Batch ? -1 : drawIndex++);
+            }
+            begin = end;
+        }
+        items.clear();
+    }
+
+private:
+    static const uint64_t MeshIndexMask = (1 << 23) - 1;
+
+    const MeshArena &arena;
+    StreamBuffer &stream;
+    bool baseInstance, multiDraw;
+    GpuBuffer DrawIndexBuffer;
+    std::vector<DrawItem> items;
+    std::vector<glm::mat4> transforms;
+    std::vector<DrawElementsCommand> commands;
+
+    // Items [begin, end) with one indirect command per mesh, its index in commands is its draw index
+    void drawRuns(size_t begin, size_t end)
+    {
+        commands.clear();
+        for (size_t i = begin; i < end; i++)
+            if (!items[i].Batch)
+                commands.push_back(MeshArena::Command(items[i].Range, commands.size()));
+        GLintptr offset = 0;
+        if (!commands.empty())
+            offset = stream.Write(&commands[0], commands.size() * sizeof(DrawElementsCommand), sizeof(GLuint));
+        // Batches in between write to the stream too and may move it to a new buffer
+        GLuint commandBuffer = stream.Buffer;
+
+        GLsizei drawIndex = 0;
+        for (size_t i = begin; i < end; )
+        {
+            const DrawItem &item = items[i];
+            if (item.Batch)
+            {
+                draw(item, -1);
+                i++;
+                continue;
+            }
+            size_t run = i + 1;
+            while (run < end && !items[run].Batch && items[run].Program == item.Program && items[run].Texture == item.Texture
+                   && items[run].FillMode == item.FillMode && items[run].PrimitiveMode == item.PrimitiveMode)
+                run++;
+            setState(item);
+            GlState::Instance().BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+            arena.MultiDraw(item.PrimitiveMode, offset + drawIndex * sizeof(DrawElementsCommand), run - i);
+            drawIndex += run - i;
+            i = run;
+        }
+    }
+
+    void setState(const DrawItem &item)
+    {
+        GlState &gl = GlState::Instance();
+        gl.UseProgram(item.Program);
+        arena.Bind();
+        gl.BindTexture(GL_TEXTURE_2D, item.Texture);
+        gl.PolygonMode(item.FillMode);
+    }
+
+    void draw(const DrawItem &item, GLint drawIndex)
+    {
+        if (item.Batch)
+        {
+            GlState::Instance().UseProgram(item.Program);
+            item.Batch();
+            return;
+        }
+        setState(item);
+        if (baseInstance)
+            arena.DrawBaseInstance(item.PrimitiveMode, item.Range, drawIndex);
+        else
+        {
+            glVertexAttribI1i(DRAW_INDEX_ATTRIBUTE, drawIndex);
+            arena.Draw(item.PrimitiveMode, item.Range);
+        }
+    }
+
+    // layer 8 bits | program 16 | texture 16 | filled 1 | first index 23
+    static uint64_t key(int layer, GLuint program, GLuint texture, GLenum fillMode, GLsizei firstIndex)
+    {
+        return (uint64_t)(layer & 0xFF) << 56 | (uint64_t)(program & 0xFFFF) << 40 | (uint64_t)(texture & 0xFFFF) << 24
+            | (uint64_t)(fillMode != GL_FILL) << 23 | ((uint64_t)firstIndex & MeshIndexMask);
+    }
+
+    static bool byKey(const DrawItem &a, const DrawItem &b) { return a.Key < b.Key; }
+
+    RenderQueue(const RenderQueue&);
+    RenderQueue& operator=(const RenderQueue&);
+};
+
+#endif
@@ -1,22 +1,30 @@
 #version 330 core
 
 // input data : sent from main program
-layout (location = 0) in vec3 vertexPosition;
-layout (location = 1) in vec3 vertexColor;
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 1) in vec4 vertexColor;   // normalized from 8 bits per channel
+layout (location = 5) in int drawIndex;      // this draw's matrix in Transforms, see RenderQueue.h
 
-uniform mat4 MVP;
+// shared by every world program, see UniformBlocks.h
+layout (std140) uniform Camera {
+    mat4 VP;
+    float PixelSize;  // world units per framebuffer pixel
+};
+layout (std140) uniform Transforms {
+    mat4 Model[256];  // MAX_DRAW_TRANSFORMS
+};
 
 // output data : used by fragment shader
 out vec3 fragColor;
 
 void main ()
 {
-    vec4 v = vec4(vertexPosition, 1); // Transform an homogeneous 4D vector
+    vec4 v = vec4(vertexPosition, 0, 1); // Transform an homogeneous 4D vector
 
     // The color of each vertex will be interpolated
     // to produce the color of each fragment
-    fragColor = vertexColor;
+    fragColor = vertexColor.rgb;
 
-    // Output position of the vertex, in clip space : MVP * position
-    gl_Position = MVP * v;
+    // Output position of the vertex, in clip space : VP * Model * position
+    gl_Position = VP * Model[drawIndex] * v;
 }
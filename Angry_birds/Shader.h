@@ -2,57 +2,27 @@
 #define SHADER_H
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
 
+#include "AssetBundle.h"
+#include "GpuResource.h"
+
 class Shader
 {
 public:
-    GLuint Program;
+    GpuProgram Program;
     // Constructor generates the shader on the fly
     Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const GLchar* geometryPath = NULL)
     {
-        // 1. Retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
+        // 1. Retrieve the vertex/fragment source code from the asset bundle or filePath
+        std::string vertexCode = ReadTextAsset(vertexPath);
+        std::string fragmentCode = ReadTextAsset(fragmentPath);
         std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensures ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // Open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // Read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // Convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-			// If geometry shader path is present, also load a geometry shader
-			if(geometryPath != NULL)
-			{
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-				gShaderStream << gShaderFile.rdbuf();
-				gShaderFile.close();
-				geometryCode = gShaderStream.str();
-			}
-        }
-        catch (std::ifstream::failure e)
-        {
+        // If geometry shader path is present, also load a geometry shader
+        if (geometryPath != NULL)
+            geometryCode = ReadTextAsset(geometryPath);
+        if (vertexCode.empty() || fragmentCode.empty() || (geometryPath != NULL && geometryCode.empty()))
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-        }
         const GLchar* vShaderCode = vertexCode.c_str();
         const GLchar * fShaderCode = fragmentCode.c_str();
         // 2. Compile shaders
@@ -80,7 +50,7 @@ public:
 			checkCompileErrors(geometry, "GEOMETRY");
 		}
         // Shader Program
-        this->Program = glCreateProgram();
+        this->Program = GpuProgram::Create();
         glAttachShader(this->Program, vertex);
         glAttachShader(this->Program, fragment);
 		if(geometryPath != NULL)
@@ -95,7 +65,7 @@ public:
 
     }
     // Uses the current shader
-    void Use() { glUseProgram(this->Program); }
+    void Use() { GlState::Instance().UseProgram(this->Program); }
 
 private:
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,89 @@
+#ifndef SHAPEBATCH_H
+#define SHAPEBATCH_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+#include "ShapeTables.h"
+#include "StreamBuffer.h"
+
+// One filled ellipse: center, radii along its own axes, rotation (radians) and color
+struct ShapeInstance {
+    GLfloat x, y;
+    GLfloat rx, ry;
+    GLfloat angle;
+    GLubyte r, g, b, a;
+};
+
+// Draws filled circles and ellipses as one quad each (shaders: Shape_GL.vert, Shape_GL.frag).
+// The fragment shader measures the distance to the rim, so edges are smooth at any zoom without MSAA
+// and without tessellating anything. Ellipses are collected every frame, written to the stream buffer
+// like InstanceBatch does, and drawn in the order they were added with one instanced call.
+// Coverage goes to alpha, so blending must be on while drawing.
+class ShapeBatch
+{
+public:
+    ShapeBatch(StreamBuffer &stream, GLsizei maxShapes = 128) : stream(stream)
+    {
+        VAO = GpuVertexArray::Create();
+        GlState::Instance().BindVertexArray(VAO);
+        // Attribute 0 - center and radii; 1 - rotation; 2 - color. They point into the stream buffer once drawn.
+        // The quad corners come from gl_VertexID, there is no per-vertex data
+        for (GLuint attribute = 0; attribute <= 2; attribute++)
+        {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+        shapes.reserve(maxShapes);
+    }
+
+    void Ellipse(GLfloat x, GLfloat y, GLfloat rx, GLfloat ry, GLfloat angle, GLubyte r, GLubyte g, GLubyte b)
+    {
+        ShapeInstance shape = { x, y, rx, ry, angle, r, g, b, 255 };
+        shapes.push_back(shape);
+    }
+
+    // Every part of a layered shape, each part scaled by (scalex, scaley) and rotated by angle around
+    // the shape's origin, which is then moved to (x, y). Parts are added in order, so features stay on top.
+    template <int N>
+    void Shape(const ShapeParts<N> &parts, GLfloat x, GLfloat y, GLfloat angle, GLfloat scalex = 1, GLfloat scaley = 1)
+    {
+        GLfloat c = cos(angle), s = sin(angle);
+        for (int i = 0; i < N; i++)
+        {
+            const ShapePart &part = parts.Parts[i];
+            GLfloat px = part.x * scalex, py = part.y * scaley;
+            Ellipse(x + c * px - s * py, y + s * px + c * py, part.rx * scalex, part.ry * scaley, angle, part.r, part.g, part.b);
+        }
+    }
+
+    GLsizei Count() const { return shapes.size(); }
+
+    // Uploads the shapes added since the last call and draws them, the shape program must be in use
+    void Draw()
+    {
+        GLsizei count = shapes.size();
+        if (count == 0)
+            return;
+
+        GLintptr offset = stream.Write(&shapes[0], count * sizeof(ShapeInstance), sizeof(ShapeInstance));
+        GlState::Instance().BindVertexArray(VAO);
+        GlState::Instance().BindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(ShapeInstance), (void*)(offset + offsetof(ShapeInstance, x)));
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(ShapeInstance), (void*)(offset + offsetof(ShapeInstance, angle)));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ShapeInstance), (void*)(offset + offsetof(ShapeInstance, r)));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        shapes.clear();
+    }
+
+private:
+    StreamBuffer &stream;
+    GpuVertexArray VAO;
+    std::vector<ShapeInstance> shapes;
+
+    ShapeBatch(const ShapeBatch&);
+    ShapeBatch& operator=(const ShapeBatch&);
+};
+
+#endif
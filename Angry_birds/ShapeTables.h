@@ -0,0 +1,189 @@
+#ifndef SHAPETABLES_H
+#define SHAPETABLES_H
+
+#include "MeshBuilder.h"
+
+// The built-in pig and bird meshes, generated by the compiler into read-only tables.
+// They are the same shapes MeshBuilder would produce at runtime, so startup only copies them into the
+// mesh arena. Shapes made while a level loads still go through MeshBuilder.
+
+// sin and cos usable in constant expressions: reduce to [-pi, pi], then a Taylor series that is
+// accurate far beyond float precision on that range
+constexpr double ConstSin(double x)
+{
+    const double pi = 3.14159265358979323846;
+    while (x > pi)
+        x -= 2 * pi;
+    while (x < -pi)
+        x += 2 * pi;
+    double term = x, sum = x;
+    for (int k = 1; k < 12; k++)
+    {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ConstCos(double x)
+{
+    return ConstSin(x + 3.14159265358979323846 / 2);
+}
+
+// Fixed-size indexed mesh filled in a constant expression, shapes are stored as in MeshBuilder
+template <int MaxVertices, int MaxIndices>
+struct StaticMesh {
+    ColorVertex Vertices[MaxVertices];
+    GLuint Indices[MaxIndices];
+    GLsizei NumVertices, NumIndices;
+
+    constexpr StaticMesh() : Vertices(), Indices(), NumVertices(0), NumIndices(0) {}
+
+    // Fan of `segments` triangles around the center, corners shared between neighbours
+    constexpr void Ellipse(double cx, double cy, double rx, double ry, int segments, GLubyte r, GLubyte g, GLubyte b)
+    {
+        GLuint center = NumVertices;
+        Vertices[NumVertices++] = ColorVertex(cx, cy, r, g, b);
+        for (int i = 0; i < segments; i++)
+        {
+            double angle = 2 * 3.14159265358979323846 * i / segments;
+            Vertices[NumVertices++] = ColorVertex(cx + rx * ConstCos(angle), cy + ry * ConstSin(angle), r, g, b);
+            Indices[NumIndices++] = center;
+            Indices[NumIndices++] = center + 1 + i;
+            Indices[NumIndices++] = center + 1 + (i + 1) % segments;
+        }
+    }
+
+    constexpr void Circle(double cx, double cy, double radius, int segments, GLubyte r, GLubyte g, GLubyte b)
+    {
+        Ellipse(cx, cy, radius, radius, segments, r, g, b);
+    }
+
+    constexpr void Triangle(double x0, double y0, double x1, double y1, double x2, double y2, GLubyte r, GLubyte g, GLubyte b)
+    {
+        Vertices[NumVertices] = ColorVertex(x0, y0, r, g, b);
+        Vertices[NumVertices + 1] = ColorVertex(x1, y1, r, g, b);
+        Vertices[NumVertices + 2] = ColorVertex(x2, y2, r, g, b);
+        for (int i = 0; i < 3; i++)
+            Indices[NumIndices++] = NumVertices + i;
+        NumVertices += 3;
+    }
+};
+
+// Level of detail: every curved shape comes in SHAPE_LODS tessellations, from coarse to fine.
+// shapeSegments is the segment count of a level's main circle, smaller features use half as many.
+// The pig used to be drawn at level 2 and the birds at level 1.
+const int SHAPE_LODS = 4;
+constexpr int shapeSegments[SHAPE_LODS] = { 12, 20, 30, 48 };
+
+// Coarsest level whose rim stays within half a pixel of the true circle, at a radius of
+// radiusPixels on screen. The gap between a chord and the arc it cuts is r * (1 - cos(pi / n)).
+inline int ShapeLod(double radiusPixels)
+{
+    for (int lod = 0; lod < SHAPE_LODS - 1; lod++)
+        if (radiusPixels * (1 - cos(M_PI / shapeSegments[lod])) <= 0.5)
+            return lod;
+    return SHAPE_LODS - 1;
+}
+
+// A round object as a stack of filled ellipses, later parts drawn over earlier ones.
+// The fan meshes below tessellate the parts, ShapeBatch draws each of them as one quad.
+struct ShapePart {
+    double x, y;         // center
+    double rx, ry;       // radii along x and y
+    GLubyte r, g, b;
+};
+
+template <int N>
+struct ShapeParts {
+    static constexpr int Count = N;
+    ShapePart Parts[N];
+};
+
+// Unit pig, scaled per instance by the pig's half width and height: body, eyes, pupils, snout and nostrils
+inline constexpr ShapeParts<8> pigParts = {{
+    { 0, 0, 1, 1, 114, 194, 65 },
+    { 0.5, 0, 0.25, 0.25, 255, 255, 255 },
+    { -0.5, 0, 0.25, 0.25, 255, 255, 255 },
+    { 0.41, 0, 0.1, 0.1, 0, 0, 0 },
+    { -0.41, 0, 0.1, 0.1, 0, 0, 0 },
+    { 0, 0.2, 0.25, 0.25, 167, 233, 1 },
+    { 0.1, 0.2, 0.08, 0.08, 31, 55, 24 },
+    { -0.1, 0.2, 0.08, 0.08, 31, 55, 24 }
+}};
+
+// Round bird of radius birdsize looking right: body, eye and pupil. The beak is a triangle, see BeakShape.
+constexpr ShapeParts<3> MakeBirdParts(double birdsize, GLubyte r, GLubyte g, GLubyte b)
+{
+    return {{
+        { 0, 0, birdsize, birdsize, r, g, b },
+        { 5, -2, 0.25 * birdsize, 0.5 * birdsize, 255, 255, 255 },
+        { 5, 0, 0.15 * birdsize, 0.15 * birdsize, 0, 0, 0 }
+    }};
+}
+
+inline constexpr ShapeParts<3> smallBirdParts = MakeBirdParts(18, 214, 1, 14);
+inline constexpr ShapeParts<3> bigBirdParts = MakeBirdParts(40, 255, 255, 0);
+
+// The beak starts at the first rim corner of a body with `segments` corners above and below the x axis
+template <int MaxVertices, int MaxIndices>
+constexpr void AddBeak(StaticMesh<MaxVertices, MaxIndices> &mesh, double birdsize, int segments)
+{
+    double beakangle = 2 * 3.14159265358979323846 / segments;
+    mesh.Triangle(birdsize * ConstCos(beakangle), birdsize * ConstSin(beakangle), birdsize + 10, -2,
+                  birdsize * ConstCos(beakangle), -birdsize * ConstSin(beakangle), 252, 187, 35);
+}
+
+// Sized for the finest level, coarser ones leave the tail of the tables unused
+typedef StaticMesh<49 + 7 * 25, 3 * (48 + 7 * 24)> PigShape;
+
+// The main circle gets the level's segments and the features half as many
+constexpr PigShape MakePigShape(int lod)
+{
+    PigShape mesh;
+    for (int i = 0; i < pigParts.Count; i++)
+    {
+        const ShapePart &part = pigParts.Parts[i];
+        mesh.Ellipse(part.x, part.y, part.rx, part.ry, i == 0 ? shapeSegments[lod] : shapeSegments[lod] / 2, part.r, part.g, part.b);
+    }
+    return mesh;
+}
+
+// Sized for the finest level like PigShape
+typedef StaticMesh<3 * 49 + 3, 3 * (3 * 48) + 3> BirdShape;
+
+constexpr BirdShape MakeBirdShape(const ShapeParts<3> &parts, int lod)
+{
+    BirdShape mesh;
+    for (int i = 0; i < parts.Count; i++)
+    {
+        const ShapePart &part = parts.Parts[i];
+        mesh.Ellipse(part.x, part.y, part.rx, part.ry, shapeSegments[lod], part.r, part.g, part.b);
+    }
+    AddBeak(mesh, parts.Parts[0].rx, shapeSegments[lod]);
+    return mesh;
+}
+
+// Beak alone, for birds whose body is drawn by ShapeBatch. It meets the body where the 20 segment fan did.
+typedef StaticMesh<3, 3> BeakShape;
+
+constexpr BeakShape MakeBeakShape(const ShapeParts<3> &parts)
+{
+    BeakShape mesh;
+    AddBeak(mesh, parts.Parts[0].rx, 20);
+    return mesh;
+}
+
+inline constexpr PigShape pigShapes[SHAPE_LODS] = { MakePigShape(0), MakePigShape(1), MakePigShape(2), MakePigShape(3) };
+inline constexpr BirdShape smallBirdShapes[SHAPE_LODS] = {
+    MakeBirdShape(smallBirdParts, 0), MakeBirdShape(smallBirdParts, 1), MakeBirdShape(smallBirdParts, 2), MakeBirdShape(smallBirdParts, 3) };
+inline constexpr BirdShape bigBirdShapes[SHAPE_LODS] = {
+    MakeBirdShape(bigBirdParts, 0), MakeBirdShape(bigBirdParts, 1), MakeBirdShape(bigBirdParts, 2), MakeBirdShape(bigBirdParts, 3) };
+inline constexpr BeakShape smallBeakShape = MakeBeakShape(smallBirdParts);
+inline constexpr BeakShape bigBeakShape = MakeBeakShape(bigBirdParts);
+
+// The finest level fills every slot, so the table sizes above match the shapes drawn into them
+static_assert(pigShapes[SHAPE_LODS - 1].NumVertices == sizeof(PigShape::Vertices) / sizeof(ColorVertex) && pigShapes[SHAPE_LODS - 1].NumIndices == sizeof(PigShape::Indices) / sizeof(GLuint), "PigShape size does not match MakePigShape");
+static_assert(smallBirdShapes[SHAPE_LODS - 1].NumVertices == sizeof(BirdShape::Vertices) / sizeof(ColorVertex) && smallBirdShapes[SHAPE_LODS - 1].NumIndices == sizeof(BirdShape::Indices) / sizeof(GLuint), "BirdShape size does not match MakeBirdShape");
+
+#endif
@@ -0,0 +1,19 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec2 shapePosition;
+in vec4 fragColor;
+
+// output data
+out vec4 color;
+
+void main()
+{
+    // Signed distance to the rim in ellipse units, divided by how much it changes per pixel
+    // it becomes pixels: half a pixel either side of the rim is blended
+    float rim = length(shapePosition) - 1.0;
+    float coverage = clamp(0.5 - rim / max(fwidth(rim), 1e-6), 0.0, 1.0);
+    if (coverage == 0.0)
+        discard;
+    color = vec4(fragColor.rgb, fragColor.a * coverage);
+}
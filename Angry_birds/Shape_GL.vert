@@ -0,0 +1,33 @@
+#version 330 core
+
+// per instance, see ShapeBatch.h
+layout (location = 0) in vec4 shapeEllipse;  // center x, y and radii
+layout (location = 1) in float shapeAngle;   // rotation in radians
+layout (location = 2) in vec4 shapeColor;    // normalized from 8 bits per channel
+
+// shared by every world program, see UniformBlocks.h
+layout (std140) uniform Camera {
+    mat4 VP;
+    float PixelSize;  // world units per framebuffer pixel
+};
+
+// output data : used by fragment shader
+out vec2 shapePosition;   // position in the ellipse, the rim is at length 1
+out vec4 fragColor;
+
+void main ()
+{
+    // Corners of the bounding quad, in triangle strip order
+    vec2 corner = vec2(float(gl_VertexID & 1) * 2.0 - 1.0, float(gl_VertexID >> 1) * 2.0 - 1.0);
+    // Grown by a pixel so the smoothed rim is not cut off by the quad edge
+    shapePosition = corner * (1.0 + PixelSize / shapeEllipse.zw);
+
+    vec2 p = shapePosition * shapeEllipse.zw;
+    float c = cos(shapeAngle), s = sin(shapeAngle);
+    p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + shapeEllipse.xy;
+
+    fragColor = shapeColor;
+
+    // Output position of the vertex, in clip space : VP * position
+    gl_Position = VP * vec4(p, 0, 1);
+}
@@ -0,0 +1,181 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+#include "GpuResource.h"
+
+// Frames the GPU may still be reading while the CPU writes the next one
+const int STREAM_FRAMES = 3;
+
+// Ring buffer for everything written every frame: instance attributes, glyph quads, per-draw transforms
+// and the camera. Each frame appends into its own region of Buffer and fences it at EndFrame. BeginFrame
+// waits on the fence of the region it is about to reuse, which has long signalled unless the GPU is
+// STREAM_FRAMES frames behind.
+// With GL 4.4 the storage is immutable and persistently mapped, so a write is a memcpy. Otherwise there
+// is one region, orphaned at BeginFrame and written with unsynchronized maps, so the driver never waits
+// either. A frame that outgrows its region moves to a bigger buffer: draw from what Write returned
+// before the next Write, and bind Buffer after the Write. Old buffers live until the next BeginFrame,
+// deleting them earlier would unbind the ranges this frame already bound from them.
+class StreamBuffer
+{
+public:
+    GpuBuffer Buffer;
+
+    StreamBuffer(GLsizeiptr regionSize = 256 * 1024)
+        : persistent(GLAD_GL_VERSION_4_4), region(0), head(0), peak(0), stalls(0), mapped(NULL)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        uniformAlignment = alignment;
+        for (int i = 0; i < STREAM_FRAMES; i++)
+            fences[i] = 0;
+        allocate(regionSize);
+    }
+
+    ~StreamBuffer() { release(); }
+
+    // Offsets of uniform block ranges must be multiples of this
+    GLsizeiptr UniformAlignment() const { return uniformAlignment; }
+
+    void BeginFrame()
+    {
+        retired.clear();
+        head = 0;
+        if (persistent)
+            wait(fences[region]);
+        else
+            orphan();
+    }
+
+    // Copies size bytes into this frame's region, at an offset from the start of Buffer that is a multiple of alignment.
+    // A range bound larger than what is written passes its size as span, so it stays inside the region; the
+    // next Write still starts right after the data, in the part of the range nothing reads.
+    GLintptr Write(const void *data, GLsizeiptr size, GLsizeiptr alignment, GLsizeiptr span = 0)
+    {
+        span = std::max(span, size);
+        GLintptr offset = aligned(regionStart() + head, alignment);
+        if (offset + span > regionStart() + regionSize)
+        {
+            // Rare, the new size sticks so following frames fit
+            GLsizeiptr needed = head + alignment + span;
+            release();
+            retired.push_back(std::move(Buffer));
+            allocate(std::max(regionSize * 2, (needed + 0xFFFF) & ~(GLsizeiptr)0xFFFF));
+            if (!persistent)
+                orphan();
+            head = 0;
+            offset = aligned(regionStart(), alignment);
+        }
+
+        if (persistent)
+            memcpy(mapped + offset, data, size);
+        else
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+            void *target = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            memcpy(target, data, size);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        head = offset + size - regionStart();
+        if (head > peak)
+            peak = head;
+        return offset;
+    }
+
+    // After the frame's last draw
+    void EndFrame()
+    {
+        if (!persistent)
+            return;
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % STREAM_FRAMES;
+    }
+
+    void Report(std::ostream &out) const
+    {
+        out << "Stream buffer: " << (persistent ? "persistent, " : "orphaned, ") << regionSize / 1024 << " KiB per frame, "
+            << peak / 1024.0 << " KiB peak, " << stalls << " waits on the GPU" << std::endl;
+    }
+
+private:
+    bool persistent;
+    GLsizeiptr regionSize, uniformAlignment;
+    int region;
+    GLsizeiptr head, peak;
+    unsigned stalls;
+    char *mapped;
+    GLsync fences[STREAM_FRAMES];
+    std::vector<GpuBuffer> retired;
+
+    GLintptr regionStart() const { return persistent ? region * regionSize : 0; }
+
+    static GLintptr aligned(GLintptr offset, GLsizeiptr alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Fresh storage for the fallback path, the draws still reading the old one keep it
+    void orphan()
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+        Buffer.Data(GL_COPY_WRITE_BUFFER, regionSize, NULL, GL_STREAM_DRAW);
+    }
+
+    void allocate(GLsizeiptr size)
+    {
+        regionSize = size;
+        Buffer = GpuBuffer::Create();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+        if (persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * STREAM_FRAMES, NULL, flags);
+            Buffer.SetBytes(regionSize * STREAM_FRAMES);
+            mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * STREAM_FRAMES, flags);
+        }
+        else
+            Buffer.Data(GL_COPY_WRITE_BUFFER, regionSize, NULL, GL_STREAM_DRAW);
+    }
+
+    // Fences and mapping of Buffer, the handle itself is reset by its owner
+    void release()
+    {
+        for (int i = 0; i < STREAM_FRAMES; i++)
+            if (fences[i])
+            {
+                glDeleteSync(fences[i]);
+                fences[i] = 0;
+            }
+        if (mapped)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            mapped = NULL;
+        }
+    }
+
+    void wait(GLsync &fence)
+    {
+        if (!fence)
+            return;
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            stalls++;
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                ;
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    StreamBuffer(const StreamBuffer&);
+    StreamBuffer& operator=(const StreamBuffer&);
+};
+
+#endif
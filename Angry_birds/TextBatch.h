@@ -0,0 +1,104 @@
+#ifndef TEXTBATCH_H
+#define TEXTBATCH_H
+
+#include <string>
+#include <vector>
+
+#include "StreamBuffer.h"
+
+// Collects the glyph quads of every string drawn in a frame and submits them in a single draw call.
+// Each vertex carries its own color and atlas page, so strings of different colors still share one batch.
+class TextBatch
+{
+public:
+    // x, y, u, v, r, g, b, page
+    static const int FloatsPerVertex = 8;
+
+    TextBatch(Font *font, Shader *shader, StreamBuffer &stream, GLsizei maxGlyphs = 256)
+        : font(font), shader(shader), stream(stream)
+    {
+        VAO = GpuVertexArray::Create();
+        GlState::Instance().BindVertexArray(VAO);
+        // Attribute 0 - position and texture coordinate packed as one vec4; 1 - text color;
+        // 2 - layer of the font atlas holding the glyph. They point into the stream buffer once flushed.
+        for (GLuint attribute = 0; attribute <= 2; attribute++)
+            glEnableVertexAttribArray(attribute);
+        vertices.reserve(maxGlyphs * 6 * FloatsPerVertex);
+    }
+
+    // Lays out a UTF-8 string starting at the baseline (x, y); nothing is sent to the GPU until Flush
+    void Add(const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+    {
+        size_t i = 0;
+        while (i < text.size())
+        {
+            const Character &ch = font->Glyph(Font::DecodeUTF8(text, i));
+            if (ch.Layer < 0)
+            {
+                x += ch.Advance * scale;
+                continue;
+            }
+
+            GLfloat xpos = x + ch.Bearing.x * scale;
+            GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+            GLfloat w = ch.Size.x * scale;
+            GLfloat h = ch.Size.y * scale;
+
+            pushVertex(xpos,     ypos + h, ch.UVMin.x, ch.UVMin.y, color, ch.Layer);
+            pushVertex(xpos,     ypos,     ch.UVMin.x, ch.UVMax.y, color, ch.Layer);
+            pushVertex(xpos + w, ypos,     ch.UVMax.x, ch.UVMax.y, color, ch.Layer);
+
+            pushVertex(xpos,     ypos + h, ch.UVMin.x, ch.UVMin.y, color, ch.Layer);
+            pushVertex(xpos + w, ypos,     ch.UVMax.x, ch.UVMax.y, color, ch.Layer);
+            pushVertex(xpos + w, ypos + h, ch.UVMax.x, ch.UVMin.y, color, ch.Layer);
+
+            // Now advance cursors for next glyph
+            x += ch.Advance * scale;
+        }
+    }
+
+    // Uploads every quad added since the last flush and draws them with one glDrawArrays
+    void Flush(const glm::mat4 &projection)
+    {
+        GLsizei numVertices = vertices.size() / FloatsPerVertex;
+        if (numVertices == 0)
+        {
+            font->ReleasePins();
+            return;
+        }
+
+        shader->Use();
+        glUniformMatrix4fv(glGetUniformLocation(shader->Program, "projection"), 1, GL_FALSE, &projection[0][0]);
+        GlState &gl = GlState::Instance();
+        gl.BindTexture(GL_TEXTURE_2D_ARRAY, font->AtlasID);
+        GLsizei stride = FloatsPerVertex * sizeof(GLfloat);
+        GLintptr offset = stream.Write(&vertices[0], vertices.size() * sizeof(GLfloat), stride);
+        gl.BindVertexArray(VAO);
+        gl.BindBuffer(GL_ARRAY_BUFFER, stream.Buffer);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 4 * sizeof(GLfloat)));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 7 * sizeof(GLfloat)));
+        glDrawArrays(GL_TRIANGLES, 0, numVertices);
+        vertices.clear();
+        // The draw is queued, glyphs it uses may now be evicted and their cells rewritten
+        font->ReleasePins();
+    }
+
+private:
+    Font *font;
+    Shader *shader;
+    StreamBuffer &stream;
+    GpuVertexArray VAO;
+    std::vector<GLfloat> vertices;
+
+    void pushVertex(GLfloat x, GLfloat y, GLfloat u, GLfloat v, const glm::vec3 &color, GLint layer)
+    {
+        GLfloat vertex[FloatsPerVertex] = { x, y, u, v, color.x, color.y, color.z, (GLfloat)layer };
+        vertices.insert(vertices.end(), vertex, vertex + FloatsPerVertex);
+    }
+
+    TextBatch(const TextBatch&);
+    TextBatch& operator=(const TextBatch&);
+};
+
+#endif
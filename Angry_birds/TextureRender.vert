@@ -1,22 +1,30 @@
 #version 330 core
 
 // input data : sent from main program
-layout (location = 0) in vec3 vertexPosition;
-layout (location = 2) in vec2 vertexTexCoord;
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 5) in int drawIndex;         // this draw's matrix in Transforms, see RenderQueue.h
+layout (location = 6) in vec2 vertexTexCoord;   // see MeshArena.h
 
-uniform mat4 MVP;
+// shared by every world program, see UniformBlocks.h
+layout (std140) uniform Camera {
+    mat4 VP;
+    float PixelSize;  // world units per framebuffer pixel
+};
+layout (std140) uniform Transforms {
+    mat4 Model[256];  // MAX_DRAW_TRANSFORMS
+};
 
 // output data : used by fragment shader
 out vec2 fragTexCoord;
 
 void main ()
 {
-    vec4 v = vec4(vertexPosition, 1); // Transform an homogeneous 4D vector
+    vec4 v = vec4(vertexPosition, 0, 1); // Transform an homogeneous 4D vector
 
     // The texture coord of each vertex will be interpolated
     // to produce the color of each fragment
     fragTexCoord = vertexTexCoord;
 
-    // Output position of the vertex, in clip space : MVP * position
-    gl_Position = MVP * v;
-}
\ No newline at end of file
+    // Output position of the vertex, in clip space : VP * Model * position
+    gl_Position = VP * Model[drawIndex] * v;
+}
@@ -0,0 +1,61 @@
+#ifndef UNIFORMBLOCKS_H
+#define UNIFORMBLOCKS_H
+
+#include "StreamBuffer.h"
+
+// Uniform blocks shared by the world programs, each at a fixed binding point:
+//   Camera      view-projection and world units per pixel, written once per frame
+//   Transforms  one model matrix per draw of the render queue, picked by the drawIndex attribute
+// The shaders declare both with std140 layout, the structs here must match.
+enum UniformBinding {
+    CAMERA_BINDING,
+    TRANSFORMS_BINDING
+};
+
+// Size of the Model array of the Transforms block, 256 matrices fill the 16 KiB every GL 3.3 driver allows
+const int MAX_DRAW_TRANSFORMS = 256;
+
+// Integer vertex attribute with the draw's index into Transforms
+const GLuint DRAW_INDEX_ATTRIBUTE = 5;
+
+// Points the program's Camera and Transforms blocks, where it has them, at their binding points
+inline void BindUniformBlocks(GLuint program)
+{
+    GLuint camera = glGetUniformBlockIndex(program, "Camera");
+    if (camera != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, camera, CAMERA_BINDING);
+    GLuint transforms = glGetUniformBlockIndex(program, "Transforms");
+    if (transforms != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, transforms, TRANSFORMS_BINDING);
+}
+
+// The Camera block. Programs read it from the stream buffer, so moving the camera is one small write.
+class CameraUniforms
+{
+public:
+    CameraUniforms(StreamBuffer &stream) : stream(stream) {}
+
+    // Once per frame, after the stream buffer's BeginFrame
+    void Update(const glm::mat4 &VP, GLfloat pixelSize)
+    {
+        Block block;
+        block.VP = VP;
+        block.PixelSize = pixelSize;
+        GLintptr offset = stream.Write(&block, sizeof(Block), stream.UniformAlignment());
+        GlState::Instance().BindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, stream.Buffer, offset, sizeof(Block));
+    }
+
+private:
+    struct Block {
+        glm::mat4 VP;
+        GLfloat PixelSize;
+        GLfloat padding[3];   // std140 rounds the block up to a multiple of 16 bytes
+    };
+
+    StreamBuffer &stream;
+
+    CameraUniforms(const CameraUniforms&);
+    CameraUniforms& operator=(const CameraUniforms&);
+};
+
+#endif
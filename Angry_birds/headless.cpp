@@ -0,0 +1,82 @@
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+#include <time.h>
+
+#include "simulation.h"
+
+using namespace std;
+
+/* Runs the game rules without a window or GL context and reports the simulation throughput */
+/* Usage: ./headless [ticks] [pullx pully] */
+/* The bird is pulled by (pullx, pully) from the sling and shot again every time it comes to rest */
+
+static double now(){
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Prints how to run the program, for arguments that can't be used */
+static int usage(const char* program){
+	cerr << "Usage: " << program << " [ticks] [pullx pully]" << endl;
+	cerr << "  ticks is a positive whole number, pullx and pully are numbers" << endl;
+	return EXIT_FAILURE;
+}
+
+/* True when the whole of text is a number, stored in value */
+static bool parseLong(const char* text, long &value){
+	char *end;
+	errno = 0;
+	value = strtol(text, &end, 10);
+	return end != text && *end == '\0' && errno == 0;
+}
+
+/* Same for a decimal number */
+static bool parseDouble(const char* text, double &value){
+	char *end;
+	errno = 0;
+	value = strtod(text, &end);
+	return end != text && *end == '\0' && errno == 0;
+}
+
+int main (int argc, char** argv){
+	long ticks = 1000000;
+	double pullx = -30, pully = 15;
+	if(argc == 3 || argc > 4)
+		return usage(argv[0]);
+	if(argc > 1 && (!parseLong(argv[1], ticks) || ticks <= 0))
+		return usage(argv[0]);
+	if(argc > 3 && (!parseDouble(argv[2], pullx) || !parseDouble(argv[3], pully)))
+		return usage(argv[0]);
+
+	setupLevel();
+
+	long shots = 0, games = 1;
+	int best = 0;
+	double start = now();
+	for(long t=0;t<ticks;t++){
+		if(pressed_state == 0){
+			// Out of birds, start over
+			if(lives == 0){
+				best = max(best, score);
+				setupLevel();
+				games++;
+			}
+			// Same as grabbing the bird with the mouse and letting it go
+			lives = max(lives-1,0);
+			initx = fireposx, inity = fireposy;
+			double x = fireposx + pullx, y = fireposy + pully;
+			releaseBird(x, y);
+			shots++;
+		}
+		simulate();
+	}
+	double elapsed = now() - start;
+	best = max(best, score);
+
+	cout << ticks << " ticks in " << elapsed << " s, " << (elapsed > 0 ? ticks / elapsed : 0) << " ticks per second" << endl;
+	cout << "Simulated " << ticks * SIM_TIMESTEP << " s of game time: " << shots << " shots, " << games << " games, best score " << best << endl;
+	return 0;
+}
@@ -4,7 +4,10 @@
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <cstring>
+#include <cstddef>
 #include <map>
+#include <memory>
 
 #include <ft2build.h>
 #include "glad/glad.h"
@@ -26,13 +29,23 @@
 #include <GL/gl.h>
 #include <GL/glu.h>
 
+#include "GpuResource.h"
+#include "AssetBundle.h"
 #include "Shader.h"
-
-#define GAME_BIRD 0
-#define GAME_WOOD_VERTICAL 1
-#define GAME_WOOD_HORIZONTAL 1
-#define GAME_PIG 2
-#define GAME_SCOREBOARD 3
+#include "simulation.h"
+#include "Font.h"
+#include "TextBatch.h"
+#include "MeshBuilder.h"
+#include "ShapeTables.h"
+#include "MeshArena.h"
+#include "StreamBuffer.h"
+#include "InstanceBatch.h"
+#include "ShapeBatch.h"
+#include "RenderQueue.h"
+#include "HudLayer.h"
+#include "FramePacer.h"
+#include "FrameProfiler.h"
+#include "GpuTimer.h"
 
 #define BITS 8
 
@@ -41,50 +54,51 @@ pid_t pid;
 using namespace std;
 void reshapeWindow (GLFWwindow* window, int width, int height);
 
+/* A drawable object: a range of the shared mesh arena plus how to draw it */
 class VAO {
 	public:
-		GLuint VertexArrayID;
-		GLuint VertexBuffer;
-		GLuint ColorBuffer;
-		GLuint TextureBuffer;
+		MeshRange Range;
 		GLuint TextureID;
 
 		GLenum PrimitiveMode;
 		GLenum FillMode;
 		int NumVertices;
-		double centerx;
-		double centery;
-		double radius;
-		double mass;
-		int type;
-		int dead;
-
-		VAO(){
+
+		VAO() : TextureID(0){
 		}
 };
 typedef struct VAO VAO;
 
-GLuint xVAO, xVBO;
-
 struct GLMatrices {
 	glm::mat4 projection;
 	glm::mat4 model;
 	glm::mat4 view;
-	GLuint MatrixID;
-	GLuint TexMatrixID; // For use with texture shader
 } Matrices;
 
-struct Character {
-    GLuint TextureID;   // ID handle of the glyph texture
-    glm::ivec2 Size;    // Size of glyph
-    glm::ivec2 Bearing;  // Offset from baseline to left/top of glyph
-    GLuint Advance;    // Horizontal offset to advance to next glyph
-};
-
-
-std::map<GLchar, Character> Characters;
-GLuint programID, fontProgramID, textureProgramID;
-int lives=4;
+MeshArena *worldMeshes;
+InstanceBatch *pigInstances[SHAPE_LODS], *woodlogInstances;
+ShapeBatch *pigEllipses, *birdEllipses;
+RenderQueue *renderQueue;
+StreamBuffer *streamBuffer;
+CameraUniforms *camera;
+// Pigs and birds are drawn as analytic ellipses, --mesh-shapes draws the tessellated fans instead
+bool meshShapes = false;
+Font *font;
+FontMode textMode = FONT_SDF;
+Shader *textShader;
+TextBatch *textBatch;
+HudLayer *hud;
+VAO *hudQuad;
+int hudscore = -1, hudlives = -1;
+FramePacer framePacer;
+FrameProfiler frameProfiler;
+GpuTimer *gpuTimer;
+string timingsPath = "frame_times.csv";
+string bundlePath = "assets.bundle";
+GpuProgram programID, fontProgramID, textureProgramID, instancedProgramID, shapeProgramID;
+GpuTexture backgroundTexture;
+// Every object made by create3DObject, freed together in releaseGL
+vector< unique_ptr<VAO> > objects;
 
 
 string tos(int t){stringstream st;st<<t;return st.str();}
@@ -96,26 +110,9 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
 	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open())
-	{
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}
-
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
-	}
+	// Read the shader code from the asset bundle, or the files when it does not have them
+	std::string VertexShaderCode = ReadTextAsset(vertex_file_path);
+	std::string FragmentShaderCode = ReadTextAsset(fragment_file_path);
 
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
@@ -170,172 +167,125 @@ static void error_callback(int error, const char* description){
 	fprintf(stderr, "Error: %s\n", description);
 }
 
+/* Free everything that owns GL objects while the context is still current */
+/* Whatever the registry still counts as live afterwards was leaked */
+void releaseGL(){
+	for(int lod=0; lod<SHAPE_LODS; lod++){
+		delete pigInstances[lod]; pigInstances[lod] = NULL;
+	}
+	delete woodlogInstances; woodlogInstances = NULL;
+	delete pigEllipses; pigEllipses = NULL;
+	delete birdEllipses; birdEllipses = NULL;
+	delete renderQueue; renderQueue = NULL;
+	delete camera; camera = NULL;
+	delete textBatch; textBatch = NULL;
+	delete textShader; textShader = NULL;
+	delete font; font = NULL;
+	delete hud; hud = NULL;
+	delete gpuTimer; gpuTimer = NULL;
+	delete worldMeshes; worldMeshes = NULL;
+	if(streamBuffer)
+		streamBuffer->Report(cout);
+	delete streamBuffer; streamBuffer = NULL;
+	objects.clear();
+	programID.Reset();
+	fontProgramID.Reset();
+	textureProgramID.Reset();
+	instancedProgramID.Reset();
+	shapeProgramID.Reset();
+	backgroundTexture.Reset();
+	GpuRegistry::Instance().Report(cout);
+}
+
 void quit(GLFWwindow *window){
+	framePacer.Report(cout);
+	frameProfiler.Dump(timingsPath);
+	releaseGL();
 	glfwDestroyWindow(window);
 	glfwTerminate();
 	kill(pid,SIGKILL);
 	exit(EXIT_SUCCESS);
 }
 
-/* Generate VAO, VBOs and return VAO handle */
-VAO* create3DObject (GLenum primitive_mode, int numVertices, int type, const GLfloat* vertex_buffer_data, const GLfloat* color_buffer_data, double centerx, double centery, double radius, GLenum fill_mode )
+/* Append the object to the mesh arena and return its handle, nothing reaches the GPU before worldMeshes->Upload() */
+/* Without an index buffer the vertices are drawn in order */
+/* Textured objects also pass one TexCoord per vertex */
+VAO* create3DObject (GLenum primitive_mode, int numVertices, const ColorVertex* vertex_buffer_data, GLenum fill_mode=GL_FILL, int numIndices=0, const GLuint* index_buffer_data=NULL, const TexCoord* tex_coord_data=NULL)
 {
-	VAO* vao = new  VAO();
+	objects.push_back(unique_ptr<VAO>(new VAO()));
+	VAO* vao = objects.back().get();
 	vao->PrimitiveMode = primitive_mode;
 	vao->NumVertices = numVertices;
 	vao->FillMode = fill_mode;
 
-	vao->centerx = centerx;
-	vao->centery = centery;
-	vao->radius = radius;
-	vao->type = type;
-	vao->dead = 0;
-
-	// Create Vertex Array Object
-	// Should be done after CreateWindow and before any other GL calls
-	glGenVertexArrays(1, &(vao->VertexArrayID)); // VAO
-	glGenBuffers (1, &(vao->VertexBuffer)); // VBO - vertices
-	glGenBuffers (1, &(vao->ColorBuffer));  // VBO - colors
-
-	glBindVertexArray (vao->VertexArrayID); // Bind the VAO 
-	glBindBuffer (GL_ARRAY_BUFFER, vao->VertexBuffer); // Bind the VBO vertices 
-	glBufferData (GL_ARRAY_BUFFER, 3*numVertices*sizeof(GLfloat), vertex_buffer_data, GL_STATIC_DRAW); // Copy the vertices into VBO
-	glVertexAttribPointer(
-			0,                  // attribute 0. Vertices
-			3,                  // size (x,y,z)
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-			);
-
-	glBindBuffer (GL_ARRAY_BUFFER, vao->ColorBuffer); // Bind the VBO colors 
-	glBufferData (GL_ARRAY_BUFFER, 3*numVertices*sizeof(GLfloat), color_buffer_data, GL_STATIC_DRAW);  // Copy the vertex colors
-	glVertexAttribPointer(
-			1,                  // attribute 1. Color
-			3,                  // size (r,g,b)
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-			);
+	vector<GLuint> sequential;
+	if(numIndices == 0){
+		for(int i=0; i<numVertices; i++)
+			sequential.push_back(i);
+		numIndices = numVertices;
+		index_buffer_data = &sequential[0];
+	}
+	vao->Range = worldMeshes->Add(vertex_buffer_data, numVertices, index_buffer_data, numIndices, tex_coord_data);
 
 	return vao;
 }
 
-/* Generate VAO, VBOs and return VAO handle - Common Color for all vertices */
-VAO* create3DObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat red, const GLfloat green, const GLfloat blue, double centerx, double centery, double radius, GLenum fill_mode)
+/* Append to the mesh arena and return VAO handle - Separate x,y,z and r,g,b float arrays, z is dropped */
+VAO* create3DObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat* color_buffer_data, GLenum fill_mode=GL_FILL)
 {
-	GLfloat* color_buffer_data = new GLfloat [3*numVertices];
-	for (int i=0; i<numVertices; i++) {
-		color_buffer_data [3*i] = red;
-		color_buffer_data [3*i + 1] = green;
-		color_buffer_data [3*i + 2] = blue;
-	}
+	vector<ColorVertex> vertices(numVertices);
+	for (int i=0; i<numVertices; i++)
+		vertices[i] = ColorVertex(vertex_buffer_data[3*i], vertex_buffer_data[3*i + 1], glm::vec3(color_buffer_data[3*i], color_buffer_data[3*i + 1], color_buffer_data[3*i + 2]));
 
-	return create3DObject(primitive_mode, numVertices, 10, vertex_buffer_data, color_buffer_data, centerx, centery, radius, fill_mode);
+	return create3DObject(primitive_mode, numVertices, &vertices[0], fill_mode);
 }
 
-
-struct VAO* create3DTexturedObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat* texture_buffer_data, GLuint textureID, GLenum fill_mode=GL_FILL)
+/* Append to the mesh arena and return VAO handle - Common Color for all vertices */
+VAO* create3DObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat red, const GLfloat green, const GLfloat blue, GLenum fill_mode=GL_FILL)
 {
-	struct VAO* vao = new struct VAO;
-	vao->PrimitiveMode = primitive_mode;
-	vao->NumVertices = numVertices;
-	vao->FillMode = fill_mode;
-	vao->TextureID = textureID;
-
-	// Create Vertex Array Object
-	// Should be done after CreateWindow and before any other GL calls
-	glGenVertexArrays(1, &(vao->VertexArrayID)); // VAO
-	glGenBuffers (1, &(vao->VertexBuffer)); // VBO - vertices
-	glGenBuffers (1, &(vao->TextureBuffer));  // VBO - textures
-
-	glBindVertexArray (vao->VertexArrayID); // Bind the VAO
-	glBindBuffer (GL_ARRAY_BUFFER, vao->VertexBuffer); // Bind the VBO vertices
-	glBufferData (GL_ARRAY_BUFFER, 3*numVertices*sizeof(GLfloat), vertex_buffer_data, GL_STATIC_DRAW); // Copy the vertices into VBO
-	glVertexAttribPointer(
-						  0,                  // attribute 0. Vertices
-						  3,                  // size (x,y,z)
-						  GL_FLOAT,           // type
-						  GL_FALSE,           // normalized?
-						  0,                  // stride
-						  (void*)0            // array buffer offset
-						  );
-
-	glBindBuffer (GL_ARRAY_BUFFER, vao->TextureBuffer); // Bind the VBO textures
-	glBufferData (GL_ARRAY_BUFFER, 2*numVertices*sizeof(GLfloat), texture_buffer_data, GL_STATIC_DRAW);  // Copy the vertex colors
-	glVertexAttribPointer(
-						  2,                  // attribute 2. Textures
-						  2,                  // size (s,t)
-						  GL_FLOAT,           // type
-						  GL_FALSE,           // normalized?
-						  0,                  // stride
-						  (void*)0            // array buffer offset
-						  );
+	vector<ColorVertex> vertices(numVertices);
+	for (int i=0; i<numVertices; i++)
+		vertices[i] = ColorVertex(vertex_buffer_data[3*i], vertex_buffer_data[3*i + 1], glm::vec3(red, green, blue));
 
-	return vao;
+	return create3DObject(primitive_mode, numVertices, &vertices[0], fill_mode);
 }
 
-/* Render the VBOs handled by VAO */
-void draw3DObject (VAO* vao)
+/* Append to the mesh arena and return VAO handle - Triangles collected by a MeshBuilder */
+VAO* create3DObject (const MeshBuilder &mesh, GLenum fill_mode=GL_FILL)
 {
-	// Change the Fill Mode for this object
-	glPolygonMode (GL_FRONT_AND_BACK, vao->FillMode);
-
-	// Bind the VAO to use
-	glBindVertexArray (vao->VertexArrayID);
-
-	// Enable Vertex Attribute 0 - 3d Vertices
-	glEnableVertexAttribArray(0);
-	// Bind the VBO to use
-	glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);
-
-	// Enable Vertex Attribute 1 - Color
-	glEnableVertexAttribArray(1);
-	// Bind the VBO to use
-	glBindBuffer(GL_ARRAY_BUFFER, vao->ColorBuffer);
-
-	// Draw the geometry !
-	glDrawArrays(vao->PrimitiveMode, 0, vao->NumVertices); // Starting from vertex 0; 3 vertices total -> 1 triangle
+	return create3DObject(GL_TRIANGLES, mesh.NumVertices(), &mesh.Vertices[0], fill_mode, mesh.NumIndices(), &mesh.Indices[0]);
 }
 
-void draw3DTexturedObject (struct VAO* vao)
+/* Append to the mesh arena and return VAO handle - Table generated at compile time, see ShapeTables.h */
+template <int MaxVertices, int MaxIndices>
+VAO* create3DObject (const StaticMesh<MaxVertices, MaxIndices> &mesh, GLenum fill_mode=GL_FILL)
 {
-	// Change the Fill Mode for this object
-	glPolygonMode (GL_FRONT_AND_BACK, vao->FillMode);
-
-	// Bind the VAO to use
-	glBindVertexArray (vao->VertexArrayID);
-
-	// Enable Vertex Attribute 0 - 3d Vertices
-	glEnableVertexAttribArray(0);
-	// Bind the VBO to use
-	glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);
-
-	// Bind Textures using texture units
-	glBindTexture(GL_TEXTURE_2D, vao->TextureID);
-
-	// Enable Vertex Attribute 2 - Texture
-	glEnableVertexAttribArray(2);
-	// Bind the VBO to use
-	glBindBuffer(GL_ARRAY_BUFFER, vao->TextureBuffer);
+	return create3DObject(GL_TRIANGLES, mesh.NumVertices, mesh.Vertices, fill_mode, mesh.NumIndices, mesh.Indices);
+}
 
-	// Draw the geometry !
-	glDrawArrays(vao->PrimitiveMode, 0, vao->NumVertices); // Starting from vertex 0; 3 vertices total -> 1 triangle
+/* Textured objects share the arena too, with their s,t texture coordinates as floats */
+struct VAO* create3DTexturedObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat* texture_buffer_data, GLuint textureID, GLenum fill_mode=GL_FILL)
+{
+	vector<ColorVertex> vertices(numVertices);
+	vector<TexCoord> texCoords(numVertices);
+	for (int i=0; i<numVertices; i++){
+		vertices[i] = ColorVertex(vertex_buffer_data[3*i], vertex_buffer_data[3*i + 1], glm::vec3(1, 1, 1));
+		texCoords[i].s = texture_buffer_data[2*i];
+		texCoords[i].t = texture_buffer_data[2*i + 1];
+	}
 
-	// Unbind Textures to be safe
-	glBindTexture(GL_TEXTURE_2D, 0);
+	struct VAO* vao = create3DObject(primitive_mode, numVertices, &vertices[0], fill_mode, 0, NULL, &texCoords[0]);
+	vao->TextureID = textureID;
+	return vao;
 }
 
 /* Create an OpenGL Texture from an image */
-GLuint createTexture (const char* filename)
+GpuTexture createTexture (const char* filename)
 {
-	GLuint TextureID;
 	// Generate Texture Buffer
-	glGenTextures(1, &TextureID);
+	GpuTexture TextureID = GpuTexture::Create();
 	// All upcoming GL_TEXTURE_2D operations now have effect on our texture buffer
-	glBindTexture(GL_TEXTURE_2D, TextureID);
+	GlState::Instance().BindTexture(GL_TEXTURE_2D, TextureID);
 	// Set our texture parameters
 	// Set texture wrapping to GL_REPEAT
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -344,13 +294,30 @@ GLuint createTexture (const char* filename)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-	// Load image and create OpenGL texture
+	// Load image and create OpenGL texture, the asset bundle has it decoded already
 	int twidth, theight;
-	unsigned char* image = SOIL_load_image(filename, &twidth, &theight, 0, SOIL_LOAD_RGB);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, twidth, theight, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+	size_t bakedSize;
+	const BakedImage* baked = (const BakedImage*)AssetBundle::Instance().Find(filename, bakedSize);
+	// A truncated asset is read from the image file instead
+	if(baked && (bakedSize < sizeof(BakedImage) || baked->Channels != 3
+			|| (uint64_t)baked->Width * baked->Height * 3 > bakedSize - sizeof(BakedImage))){
+		cout << "ERROR::ASSETS: Baked " << filename << " is truncated" << endl;
+		baked = NULL;
+	}
+	unsigned char* image = NULL;
+	if(baked){
+		twidth = baked->Width;
+		theight = baked->Height;
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, twidth, theight, 0, GL_RGB, GL_UNSIGNED_BYTE, baked + 1);
+	}
+	else{
+		image = SOIL_load_image(filename, &twidth, &theight, 0, SOIL_LOAD_RGB);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, twidth, theight, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+	}
 	glGenerateMipmap(GL_TEXTURE_2D); // Generate MipMaps to use
-	SOIL_free_image_data(image); // Free the data read from file after creating opengl texture
-	glBindTexture(GL_TEXTURE_2D, 0); // Unbind texture when done, so we won't accidentily mess it up
+	TextureID.SetBytes((size_t)twidth * theight * 3 * 4 / 3); // The mip chain adds a third
+	if(image)
+		SOIL_free_image_data(image); // Free the data read from file after creating opengl texture
 
 	return TextureID;
 }
@@ -359,21 +326,26 @@ GLuint createTexture (const char* filename)
  * Customizable functions *
  **************************/
 
-int pressed_state = 0, collision_state=0, zoominstate = 0, zoomoutstate = 0, panright = 0, panleft = 0, panup = 0, pandown = 0;
-int keyboard_pressed_statex = 0, keyboard_pressed_statey = 0;
-double curx,cury,initx = -380,inity = 130,speedx,speedy,strength=0.5,prevx,prevy,cannonball_size=18,gravity=0.2;
-double fireposx=-380,fireposy=130, keyboardx = -380 , keyboardy = 130;
-double pivotx=-10,pivoty=-30,angular_v[6],angle[6],woodspx[6],woodspy[6],pigspx[10], pigspy[10], piginitx[10];
-VAO  *cannonball[2], *gameFloor, *woodlogs[6], *pigs[10], *powerboard, *powerelement, *background, *catapult;
-int poscannonball=0;
+int zoominstate = 0, zoomoutstate = 0, panright = 0, panleft = 0, panup = 0, pandown = 0;
+VAO  *birdMesh[2][SHAPE_LODS], *beakMesh[2], *gameFloor, *woodlogMesh, *woodlogUnitMesh, *pigMesh[SHAPE_LODS], *powerboard, *powerelement, *background, *catapult;
 float screenleft = -600.0f, screenright = 600.0f, screentop = -300.0f, screenbotton = 300.0f;
-int scoretimer[10][3],tim=5;
-int pig_wood[10];
-int panning_state=0, paninitx, paninity;
+int viewportWidth = 1200;
+
+/* Framebuffer pixels per world unit at the current zoom, curved shapes pick their level of detail from it */
+double pixelsPerUnit(){
+	return viewportWidth / (screenright - screenleft);
+}
 
-int score = 0;
+/* Draw the ellipses collected in a shape batch with their rims blended, the shape program must be in use */
+void drawShapes(ShapeBatch *shapes){
+	GlState &gl = GlState::Instance();
+	gl.Enable(GL_BLEND);
+	gl.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	shapes->Draw();
+	gl.Disable(GL_BLEND);
+}
+int panning_state=0, paninitx, paninity;
 
-double power = 0;
 /* Executed when a regular key is pressed/released/held-down */
 /* Prefered for Keyboard events */
 void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods){
@@ -406,6 +378,12 @@ void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods){
 			case GLFW_KEY_X:
 				// do something ..
 				break;
+			case GLFW_KEY_F12:
+				frameProfiler.Dump(timingsPath);
+				GpuRegistry::Instance().Report(cout);
+				GlState::Instance().Report(cout);
+				streamBuffer->Report(cout);
+				break;
 			case GLFW_KEY_A:
 				keyboard_pressed_statex = 0;
 				break;
@@ -458,14 +436,7 @@ void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods){
 				}
 				break;
 			case GLFW_KEY_SPACE:
-				pressed_state = 3;
-				if(sqrt((keyboardx-initx)*(keyboardx-initx)+(keyboardy-inity)*(keyboardy-inity)) > 30){
-					double angle_present = -M_PI+atan2(inity-keyboardy,initx-keyboardx);
-					keyboardx = initx + 30*cos(angle_present);
-					keyboardy = inity + 30*sin(angle_present);
-				}
-				speedx=(initx-keyboardx)*strength;
-				speedy=(inity-keyboardy)*strength;
+				releaseBird(keyboardx, keyboardy);
 				break;
 
 			default:
@@ -537,9 +508,9 @@ static void cursor_position_callback(GLFWwindow* window, double xpos, double ypo
 }
 
 int is_cannon_clicked(double mousex, double mousey) {
-	double x2=cannonball[poscannonball]->centerx;
-	double y2=cannonball[poscannonball]->centery;
-	double radius = cannonball[poscannonball]->radius;
+	double x2=cannonball[poscannonball].centerx;
+	double y2=cannonball[poscannonball].centery;
+	double radius = cannonball[poscannonball].radius;
 	if(radius>sqrt((x2-mousex)*(x2-mousex)+(y2-mousey)*(y2-mousey)))
 		return true;
 	else
@@ -563,27 +534,14 @@ void mouseButton (GLFWwindow* window, int button, int action, int mods)
 
 			//hacer un click para que el bird regrese a su posicion inicial
 			if(pressed_state==3){
-				pressed_state=0;
-				gravity = 0.2;
-				power = 0;
-				keyboardx = fireposx;
-				keyboardy = fireposy;
+				resetBird();
 			}
 
 			//enfocar al juego, que se encuentre activo
 			if (action == GLFW_RELEASE ){
 				//triangle_rot_dir *= -1;
 				if(pressed_state==1){
-					pressed_state=3;
-
-					if(sqrt((curx-initx)*(curx-initx)+(cury-inity)*(cury-inity)) > 30){
-						double angle_present = -M_PI+atan2(inity-cury,initx-curx);
-						curx = initx + 30*cos(angle_present);
-						cury = inity + 30*sin(angle_present);
-					}
-					speedx=(initx-curx)*strength;
-					speedy=(inity-cury)*strength;
-
+					releaseBird(curx, cury);
 				}
 				//printf("pressed at %lf %lf and released at %lf %lf",initx,inity,curx,cury);
 			}
@@ -617,6 +575,7 @@ void reshapeWindow (GLFWwindow* window, int width, int height)
 
 	// sets the viewport of openGL renderer
 	glViewport (0, 0, (GLsizei) fbwidth, (GLsizei) fbheight);
+	viewportWidth = fbwidth;
 
 	// set the projection matrix as perspective
 	/* glMatrixMode (GL_PROJECTION);
@@ -632,24 +591,9 @@ void reshapeWindow (GLFWwindow* window, int width, int height)
 }
 
 void createPowerElement() {
-	static GLfloat vertex_buffer_data[] = {
-		-0.5, -15.0f*0.75, 0,
-		0.5, -15.0f*0.75f, 0,
-		-0.5, 15.0f*0.75f, 0,
-
-		0.5, -15.0f*0.75f, 0,
-		-0.5, 15.0f*0.75f, 0,
-		0.5, 15.0f*0.75f, 0
-	};
-	static GLfloat color_buffer_data[] = {
-		12.0f/255.0f,253.0f/255.0f,1.0f/255.0f,
-		12.0f/255.0f,253.0f/255.0f,1.0f/255.0f,
-		12.0f/255.0f,253.0f/255.0f,1.0f/255.0f,
-		12.0f/255.0f,253.0f/255.0f,1.0f/255.0f,
-		12.0f/255.0f,253.0f/255.0f,1.0f/255.0f,
-		12.0f/255.0f,253.0f/255.0f,1.0f/255.0f
-	};
-	powerelement = create3DObject(GL_TRIANGLES, 2*3 ,GAME_SCOREBOARD, vertex_buffer_data, color_buffer_data, -400 + 30, -270 +15, 30, GL_FILL);
+	MeshBuilder mesh;
+	mesh.Quad(-0.5, -15.0f*0.75f, 0.5, 15.0f*0.75f, MeshBuilder::RGB(12,253,1));
+	powerelement = create3DObject(mesh);
 }
 
 void createPowerBoard(){
@@ -659,448 +603,44 @@ void createPowerBoard(){
 	double height = 15;
 	double innerratio = 0.83;
 
-	static  GLfloat vertex_buffer_data[] = {
-		leftoffset - width, topoffset - height, 0,
-		leftoffset + width, topoffset - height, 0,
-		leftoffset - width, topoffset + height, 0,
-
-		leftoffset + width, topoffset - height, 0,
-		leftoffset - width, topoffset + height, 0,
-		leftoffset + width, topoffset + height, 0,
-
-		leftoffset - width * innerratio, topoffset - height * innerratio, 0,
-		leftoffset + width * innerratio, topoffset - height * innerratio, 0,
-		leftoffset - width * innerratio, topoffset + height * innerratio, 0,
-
-		leftoffset + width * innerratio, topoffset - height * innerratio, 0,
-		leftoffset - width * innerratio, topoffset + height * innerratio, 0,
-		leftoffset + width * innerratio, topoffset + height * innerratio, 0,
-		
-	};
-	static GLfloat color_buffer_data[] = {
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		
-		123.0f/255.0f,187.0f/255.0f,70.0f/255.0f,
-		123.0f/255.0f,187.0f/255.0f,70.0f/255.0f,
-		123.0f/255.0f,187.0f/255.0f,70.0f/255.0f,
-		123.0f/255.0f,187.0f/255.0f,70.0f/255.0f,
-		123.0f/255.0f,187.0f/255.0f,70.0f/255.0f,
-		123.0f/255.0f,187.0f/255.0f,70.0f/255.0f
-	};
-
-	powerboard = create3DObject(GL_TRIANGLES, 4*3 ,GAME_SCOREBOARD, vertex_buffer_data, color_buffer_data, -400 + 30, -270 +15, 30, GL_FILL);
+	MeshBuilder mesh;
+	mesh.Quad(leftoffset - width, topoffset - height, leftoffset + width, topoffset + height, MeshBuilder::RGB(228,142,57));
+	mesh.Quad(leftoffset - width * innerratio, topoffset - height * innerratio,
+			leftoffset + width * innerratio, topoffset + height * innerratio, MeshBuilder::RGB(123,187,70));
+	powerboard = create3DObject(mesh);
 }
 
+/* One unit pig per level of detail for every instance, the shapes are generated at compile time in ShapeTables.h */
 void createPig ()
 {
-	// GL3 accepts only Triangles. Quads are not supported
-	double n=30;
-	static GLfloat vertex_buffer_data[6][9*30+2*3 +9*15*2 + 9*15*2 + 9*15 + 9*15 * 2];
-	static GLfloat color_buffer_data[6][9*30+2*3 + 9*15*2 + 9*15*2 + 9*15 + 9*15 * 2];
-	double sizea[6]={18 + 5, 23 +5 , 20 + 5, 25 + 5, 20 + 5, 28 + 5},sizeb[6]={18, 23, 20, 25, 20, 28};
-	double eyeline = 0.5;
-	float angle=0;
-	for(int j=0;j<6;j++)
-		for(int i=0;i<n;i++){
-			vertex_buffer_data[j][9*i] = vertex_buffer_data[j][9*i+1] = vertex_buffer_data[j][9*i+2] = 0;
-			vertex_buffer_data[j][9*i+3]=sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+4]=sizeb[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+5]=0;
-			angle += 360.0f/n;
-			vertex_buffer_data[j][9*i+6]=sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+7]=sizeb[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+8]=0;
-
-			color_buffer_data[j][9*i] = 114.0f/255.0f;
-			color_buffer_data[j][9*i+1] = 194.0f/255.0f;
-			color_buffer_data[j][9*i+2] = 65.0f/255.0f;
-			color_buffer_data[j][9*i+3] = 114.0f/255.0f;
-			color_buffer_data[j][9*i+4] = 194.0f/255.0f;
-			color_buffer_data[j][9*i+5] = 65.0f/255.0f;
-			color_buffer_data[j][9*i+6] = 114.0f/255.0f;
-			color_buffer_data[j][9*i+7] = 194.0f/255.0f;
-			color_buffer_data[j][9*i+8] = 65.0f/255.0f;
-		}
-	angle = 0;
-	float ap;
-	for(int j=0;j<6;j++,angle=0)
-		for(int i=n;i<2*n;i++){
-			if(i<n+(n/2))
-				ap = sizea[j]/2;
-			else
-				ap = -sizea[j]/2;
-			if(i==n+n/2) angle = 0;
-			vertex_buffer_data[j][9*i]=ap,vertex_buffer_data[j][9*i+1]=-0.5,vertex_buffer_data[j][9*i+2] = 0;
-			vertex_buffer_data[j][9*i+3]=ap+0.25*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+4]=-0.5+0.25*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+5]=0;
-			angle += 360.0f/(n/2);
-			vertex_buffer_data[j][9*i+6]=ap+0.25*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+7]=-0.5+0.25*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+8]=0;
-
-			color_buffer_data[j][9*i] = 1;//.0f/255.0f;
-			color_buffer_data[j][9*i+1] = 1;//194.0f/255.0f;
-			color_buffer_data[j][9*i+2] = 1;//65.0f/255.0f;
-			color_buffer_data[j][9*i+3] = 1;//114.0f/255.0f;
-			color_buffer_data[j][9*i+4] = 1;//194.0f/255.0f;
-			color_buffer_data[j][9*i+5] = 1;//65.0f/255.0f;
-			color_buffer_data[j][9*i+6] = 1;//114.0f/255.0f;
-			color_buffer_data[j][9*i+7] = 1;//194.0f/255.0f;
-			color_buffer_data[j][9*i+8] = 1;//65.0f/255.0f;
-		}
-	for(int j=0;j<6;j++,angle=0)
-		for(int i=2*n;i<3*n;i++){
-			if(i<2*n+(n/2))
-				ap = 0.41*sizea[j];
-			else
-				ap = -0.41*sizea[j];
-			if(i==2*n+n/2) angle = 0;
-			vertex_buffer_data[j][9*i]=ap,vertex_buffer_data[j][9*i+1]=-0.5,vertex_buffer_data[j][9*i+2] = 0;
-			vertex_buffer_data[j][9*i+3]=ap+0.1*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+4]=-0.5+0.1*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+5]=0;
-			angle += 360.0f/(n/2);
-			vertex_buffer_data[j][9*i+6]=ap+0.1*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+7]=-0.5+0.1*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+8]=0;
-
-			color_buffer_data[j][9*i] = 0;//.0f/255.0f;
-			color_buffer_data[j][9*i+1] = 0;//194.0f/255.0f;
-			color_buffer_data[j][9*i+2] = 0;//65.0f/255.0f;
-			color_buffer_data[j][9*i+3] = 0;//114.0f/255.0f;
-			color_buffer_data[j][9*i+4] = 0;//194.0f/255.0f;
-			color_buffer_data[j][9*i+5] = 0;//65.0f/255.0f;
-			color_buffer_data[j][9*i+6] = 0;//114.0f/255.0f;
-			color_buffer_data[j][9*i+7] = 0;//194.0f/255.0f;
-			color_buffer_data[j][9*i+8] = 0;//65.0f/255.0f;
-		}
-	angle = 0;
-	for(int j=0;j<6;j++,angle=0)
-		for(int i=3*n;i<3*n + n/2;i++){
-			vertex_buffer_data[j][9*i]=0,vertex_buffer_data[j][9*i+1]=5,vertex_buffer_data[j][9*i+2] = 0;
-			vertex_buffer_data[j][9*i+3]=0.25*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+4]=5+0.25*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+5]=0;
-			angle += 360.0f/(n/2);
-			vertex_buffer_data[j][9*i+6]=0.25*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+7]=5+0.25*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+8]=0;
-//rgb(167,233,1)
-			color_buffer_data[j][9*i] = 167.0f/255.0f;
-			color_buffer_data[j][9*i+1] = 233.0f/255.0f;
-			color_buffer_data[j][9*i+2] = 1.0f/255.0f;
-			color_buffer_data[j][9*i+3] = 167.0f/255.0f;
-			color_buffer_data[j][9*i+4] = 233.0f/255.0f;
-			color_buffer_data[j][9*i+5] = 1.0f/255.0f;
-			color_buffer_data[j][9*i+6] = 167.0f/255.0f;
-			color_buffer_data[j][9*i+7] = 233.0f/255.0f;
-			color_buffer_data[j][9*i+8] = 1.0f/255.0f;
-		}
-	angle = 0;
-	for(int j=0;j<6;j++,angle=0)
-		for(int i=3*n + n/2;i<4*n + n/2;i++){
-			if(i<4*n)
-				ap = 0.1*sizea[j];
-			else
-				ap = -0.1*sizea[j];
-			if(i==4*n) angle = 0;
-			vertex_buffer_data[j][9*i]=ap,vertex_buffer_data[j][9*i+1]=5,vertex_buffer_data[j][9*i+2] = 0;
-			vertex_buffer_data[j][9*i+3]=ap+0.08*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+4]=5+0.08*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+5]=0;
-			angle += 360.0f/(n/2);
-			vertex_buffer_data[j][9*i+6]=ap+0.08*sizea[j]*cos(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+7]=5+0.08*sizea[j]*sin(angle*M_PI/180.0f);
-			vertex_buffer_data[j][9*i+8]=0;
-//rgb(31,55,24)
-			color_buffer_data[j][9*i] = 31.0f/255.0f;
-			color_buffer_data[j][9*i+1] = 55.0f/255.0f;
-			color_buffer_data[j][9*i+2] = 24.0/255.0f;
-			color_buffer_data[j][9*i+3] = 31.0f/255.0f;
-			color_buffer_data[j][9*i+4] = 55.0f/255.0f;
-			color_buffer_data[j][9*i+5] = 24.0f/255.0f;
-			color_buffer_data[j][9*i+6] = 31.0f/255.0f;
-			color_buffer_data[j][9*i+7] = 55.0f/255.0f;
-			color_buffer_data[j][9*i+8] = 24.0f/255.0f;
-		}
-	piginitx[0]=50, piginitx[1]=345, piginitx[2] = 415, piginitx[3] = 280, piginitx[4] = 70,piginitx[5] = 100;
-	// create3DObject creates and returns a handle to a VAO that can be used later
-	pigs[0] = create3DObject(GL_TRIANGLES, 4*n*3 + (n/2) *3  ,GAME_PIG, vertex_buffer_data[0], color_buffer_data[0], 50, 200-sizeb[0], sizea[0], GL_FILL);
-	pigs[1] = create3DObject(GL_TRIANGLES, 4*n*3 + (n/2) *3 ,GAME_PIG, vertex_buffer_data[1], color_buffer_data[1], 345, 200-50-sizeb[1], sizea[1], GL_FILL);
-	pigs[2] = create3DObject(GL_TRIANGLES, 4*n*3 + (n/2) *3  ,GAME_PIG, vertex_buffer_data[2], color_buffer_data[2], 415, 200-sizeb[2], sizea[2], GL_FILL);
-	pigs[3] = create3DObject(GL_TRIANGLES, 4*n*3 + (n/2) *3  ,GAME_PIG, vertex_buffer_data[3], color_buffer_data[3], 280, 200-50-40-sizeb[3], sizea[3], GL_FILL);
-	pigs[4] = create3DObject(GL_TRIANGLES, 4*n*3 + (n/2) *3  ,GAME_PIG, vertex_buffer_data[4], color_buffer_data[4], 70, -110 - 10- sizeb[4], sizea[4], GL_FILL);
-	pigs[5] = create3DObject(GL_TRIANGLES, 4*n*3 + (n/2) *3  ,GAME_PIG, vertex_buffer_data[5], color_buffer_data[5], 100, -210 - 10- sizeb[5], sizea[4], GL_FILL);
-
-	pig_wood[3] = 1;
-	pig_wood[1] = 2;
-}
-
-// Creates the rectangle object used in this sample code
-void createCannonball (){
-	// GL3 accepts only Triangles. Quads are not supported
-	double n=20;
-	static GLfloat vertex_buffer_data[9*20 + 2*3 + 2*9*20 + 9*20];
-	static GLfloat color_buffer_data [9*20 + 2*3 + 2*9*20 +9*20];
-	float angle=0;
-	for(int i=0;i<n;i++){
-		vertex_buffer_data[9*i] = vertex_buffer_data[9*i+1] = vertex_buffer_data[9*i+2] = 0;
-		vertex_buffer_data[9*i+3]=cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+4]=cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+5]=0;
-		angle += 360.0f/n;
-		vertex_buffer_data[9*i+6]=cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+7]=cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+8]=0;
-
-		color_buffer_data[9*i] = 214.0f/255.0f;
-		color_buffer_data[9*i+1] = 1.0f/255.0f;
-		color_buffer_data[9*i+2] = 14.0f/255.0f;
-		color_buffer_data[9*i+3] = 214.0f/255.0f;
-		color_buffer_data[9*i+4] = 1.0f/255.0f;
-		color_buffer_data[9*i+5] = 14.0f/255.0f;
-		color_buffer_data[9*i+6] = 214.0f/255.0f;
-		color_buffer_data[9*i+7] = 1.0f/255.0f;
-		color_buffer_data[9*i+8] = 14.0f/255.0f;
-	}
-	angle= 0;
-	for(int i=n;i<n+n;i++){
-		vertex_buffer_data[9*i] =5; vertex_buffer_data[9*i+1] =-2; vertex_buffer_data[9*i+2] = 0;
-		vertex_buffer_data[9*i+3]=5+cannonball_size*0.25*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+4]=-2+cannonball_size*0.5*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+5]=0;
-		angle += 360.0f/(n);
-		vertex_buffer_data[9*i+6]=5+cannonball_size*0.25*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+7]=-2+cannonball_size*0.5*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+8]=0;
-
-		color_buffer_data[9*i] = 1;
-		color_buffer_data[9*i+1] = 1;
-		color_buffer_data[9*i+2] = 1;
-		color_buffer_data[9*i+3] = 1;
-		color_buffer_data[9*i+4] = 1;
-		color_buffer_data[9*i+5] = 1;
-		color_buffer_data[9*i+6] = 1;
-		color_buffer_data[9*i+7] = 1;
-		color_buffer_data[9*i+8] = 1;
-	}
-	angle =0 ;
-	for(int i=2*n;i<2*n+n;i++){
-		vertex_buffer_data[9*i] = 5;vertex_buffer_data[9*i+1] =0; vertex_buffer_data[9*i+2] = 0;
-		vertex_buffer_data[9*i+3]=5+0.15*cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+4]=0.15*cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+5]=0;
-		angle += 360.0f/n;
-		vertex_buffer_data[9*i+6]=5+0.15*cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+7]=0.15*cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+8]=0;
-
-		color_buffer_data[9*i] = 0;
-		color_buffer_data[9*i+1] = 0;
-		color_buffer_data[9*i+2] = 0;
-		color_buffer_data[9*i+3] = 0;
-		color_buffer_data[9*i+4] = 0;
-		color_buffer_data[9*i+5] = 0;
-		color_buffer_data[9*i+6] = 0;
-		color_buffer_data[9*i+7] = 0;
-		color_buffer_data[9*i+8] = 0;
-	}
-
-	for(int i=9*3*n;i<9*(3*n+2);i+=3){
-		color_buffer_data[i] =252.0f/255.0f;
-		color_buffer_data[i+1] = 187.0f/255.0f;
-		color_buffer_data[i+2] = 35.0f/255.0f;
-	}
-
-	vertex_buffer_data[9*20*3] = cannonball_size*cos((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+1] = cannonball_size*sin((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+2] = 0;
-	vertex_buffer_data[9*20*3+3] = cannonball_size+10;
-	vertex_buffer_data[9*20*3+4] = -2;
-	vertex_buffer_data[9*20*3+5] = 0;
-	vertex_buffer_data[9*20*3+6] = cannonball_size*cos((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+7] = -cannonball_size*sin((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+8] = 0;
-	// create3DObject creates and returns a handle to a VAO that can be used later
-	cannonball[0] = create3DObject(GL_TRIANGLES, 3*n*3 + 2*3, GAME_BIRD, vertex_buffer_data, color_buffer_data,  0, 0, cannonball_size, GL_FILL);
-}
-
-
-
-// Creates the rectangle object used in this sample code
-void createCannonball2 (){
-	cannonball_size=40;
-	// GL3 accepts only Triangles. Quads are not supported
-	double n=20;
-	static GLfloat vertex_buffer_data[9*20 + 2*3 + 2*9*20 + 9*20];
-	static GLfloat color_buffer_data [9*20 + 2*3 + 2*9*20 +9*20];
-	float angle=0;
-	for(int i=0;i<n;i++){
-		vertex_buffer_data[9*i] = vertex_buffer_data[9*i+1] = vertex_buffer_data[9*i+2] = 0;
-		vertex_buffer_data[9*i+3]=cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+4]=cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+5]=0;
-		angle += 360.0f/n;
-		vertex_buffer_data[9*i+6]=cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+7]=cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+8]=0;
-
-		color_buffer_data[9*i] = 255.0f/255.0f;
-		color_buffer_data[9*i+1] = 255.0f/255.0f;
-		color_buffer_data[9*i+2] = 0.0f/255.0f;
-		color_buffer_data[9*i+3] = 255.0f/255.0f;
-		color_buffer_data[9*i+4] = 255.0f/255.0f;
-		color_buffer_data[9*i+5] = 0.0f/255.0f;
-		color_buffer_data[9*i+6] = 255.0f/255.0f;
-		color_buffer_data[9*i+7] = 255.0f/255.0f;
-		color_buffer_data[9*i+8] = 0.0f/255.0f;
-	}
-	angle= 0;
-	for(int i=n;i<n+n;i++){
-		vertex_buffer_data[9*i] =5; vertex_buffer_data[9*i+1] =-2; vertex_buffer_data[9*i+2] = 0;
-		vertex_buffer_data[9*i+3]=5+cannonball_size*0.25*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+4]=-2+cannonball_size*0.5*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+5]=0;
-		angle += 360.0f/(n);
-		vertex_buffer_data[9*i+6]=5+cannonball_size*0.25*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+7]=-2+cannonball_size*0.5*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+8]=0;
-
-		color_buffer_data[9*i] = 1;
-		color_buffer_data[9*i+1] = 1;
-		color_buffer_data[9*i+2] = 1;
-		color_buffer_data[9*i+3] = 1;
-		color_buffer_data[9*i+4] = 1;
-		color_buffer_data[9*i+5] = 1;
-		color_buffer_data[9*i+6] = 1;
-		color_buffer_data[9*i+7] = 1;
-		color_buffer_data[9*i+8] = 1;
-	}
-	angle =0 ;
-	for(int i=2*n;i<2*n+n;i++){
-		vertex_buffer_data[9*i] = 5;vertex_buffer_data[9*i+1] =0; vertex_buffer_data[9*i+2] = 0;
-		vertex_buffer_data[9*i+3]=5+0.15*cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+4]=0.15*cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+5]=0;
-		angle += 360.0f/n;
-		vertex_buffer_data[9*i+6]=5+0.15*cannonball_size*cos(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+7]=0.15*cannonball_size*sin(angle*M_PI/180.0f);
-		vertex_buffer_data[9*i+8]=0;
-
-		color_buffer_data[9*i] = 0;
-		color_buffer_data[9*i+1] = 0;
-		color_buffer_data[9*i+2] = 0;
-		color_buffer_data[9*i+3] = 0;
-		color_buffer_data[9*i+4] = 0;
-		color_buffer_data[9*i+5] = 0;
-		color_buffer_data[9*i+6] = 0;
-		color_buffer_data[9*i+7] = 0;
-		color_buffer_data[9*i+8] = 0;
-	}
-
-	for(int i=9*3*n;i<9*(3*n+2);i+=3){
-		color_buffer_data[i] =252.0f/255.0f;
-		color_buffer_data[i+1] = 187.0f/255.0f;
-		color_buffer_data[i+2] = 35.0f/255.0f;
-	}
-
-	vertex_buffer_data[9*20*3] = cannonball_size*cos((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+1] = cannonball_size*sin((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+2] = 0;
-	vertex_buffer_data[9*20*3+3] = cannonball_size+10;
-	vertex_buffer_data[9*20*3+4] = -2;
-	vertex_buffer_data[9*20*3+5] = 0;
-	vertex_buffer_data[9*20*3+6] = cannonball_size*cos((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+7] = -cannonball_size*sin((360.0f/n) *M_PI/180.0f);
-	vertex_buffer_data[9*20*3+8] = 0;
-	// create3DObject creates and returns a handle to a VAO that can be used later
-	cannonball[1] = create3DObject(GL_TRIANGLES, 3*n*3 + 2*3, GAME_BIRD, vertex_buffer_data, color_buffer_data,  0, 0, cannonball_size, GL_FILL);
+	for(int lod=0; lod<SHAPE_LODS; lod++)
+		pigMesh[lod] = create3DObject(pigShapes[lod]);
 }
 
-
 void createGameFloor ()
 {
-	static GLfloat vertex_buffer_data [20*18];
-
+	// 20 overlapping strips, each a little lower and lighter than the one above
+	MeshBuilder mesh;
 	double base=200;
-	for(int i=0;i<20;i++){
-		vertex_buffer_data[18*i]=-600,vertex_buffer_data[18*i+1]=base,vertex_buffer_data[18*i+2]=0;
-		vertex_buffer_data[18*i+3]=-600,vertex_buffer_data[18*i+4]=base+10,vertex_buffer_data[18*i+5]=0;
-		vertex_buffer_data[18*i+6]=600,vertex_buffer_data[18*i+7]=base,vertex_buffer_data[18*i+8]=0;
-		vertex_buffer_data[18*i+9]=600,vertex_buffer_data[18*i+10]=base+10,vertex_buffer_data[18*i+11]=0;
-		vertex_buffer_data[18*i+12]=-600,vertex_buffer_data[18*i+13]=base+10,vertex_buffer_data[18*i+14]=0;
-		vertex_buffer_data[18*i+15]=600,vertex_buffer_data[18*i+16]=base,vertex_buffer_data[18*i+17]=0;
-		base+=5;
-	}
-
-	static  GLfloat color_buffer_data [20*18]; 
 	double gred=133.0/255.0f,ggreen=183.0/255.0f,gblue=52.0/255.0f;
 	for(int i=0;i<20;i++){
-		color_buffer_data[18*i]=gred,color_buffer_data[18*i+1]=ggreen,color_buffer_data[18*i+2]=gblue;
-		color_buffer_data[18*i+3]=gred,color_buffer_data[18*i+4]=ggreen,color_buffer_data[18*i+5]=gblue;
-		color_buffer_data[18*i+6]=gred,color_buffer_data[18*i+7]=ggreen,color_buffer_data[18*i+8]=gblue;
-		color_buffer_data[18*i+9]=gred,color_buffer_data[18*i+10]=ggreen,color_buffer_data[18*i+11]=gblue;
-		color_buffer_data[18*i+12]=gred,color_buffer_data[18*i+13]=ggreen,color_buffer_data[18*i+14]=gblue;
-		color_buffer_data[18*i+15]=gred,color_buffer_data[18*i+16]=ggreen,color_buffer_data[18*i+17]=gblue;
+		mesh.Quad(-600, base, 600, base+10, glm::vec3(gred, ggreen, gblue));
+		base+=5;
 		ggreen+=10.0f/255.0f;
 		gred+=2.5f/255.0f;
 	}
-	gameFloor = create3DObject(GL_TRIANGLES, 20*6, GAME_WOOD_HORIZONTAL, vertex_buffer_data, color_buffer_data, GL_FILL, fireposx, fireposy, 25);
+	gameFloor = create3DObject(mesh);
 }
 
-GLfloat woodsizex[6],woodsizey[6];
 void createWoodLogs(){
-
-
-	static GLfloat vertex_buffer_data[6][18];
-	woodsizex[0] = 10;
-	woodsizey[0] = 30;
-	woodsizex[1] = 35;
-	woodsizey[1] = 20;
-	woodsizex[2] = 75;
-	woodsizey[2] = 25;
-	woodsizex[3] = 10;
-	woodsizey[3] = 100;
-	woodsizex[4] = 50;
-	woodsizey[4] = 10;
-	woodsizex[5] = 50;
-	woodsizey[5] = 10;
-
-	for(int i=0;i<=5;i++){
-		vertex_buffer_data[i][0] = vertex_buffer_data[i][3] = vertex_buffer_data[i][12] = -woodsizex[i];
-		vertex_buffer_data[i][6] = vertex_buffer_data[i][9] = vertex_buffer_data[i][15] = woodsizex[i];
-		vertex_buffer_data[i][1] = vertex_buffer_data[i][7] = vertex_buffer_data[i][10] = woodsizey[i];
-		vertex_buffer_data[i][4] = vertex_buffer_data[i][13] = vertex_buffer_data[i][16] = -woodsizey[i];
-	}
-	static const GLfloat color_buffer_data [] = {
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f,
-		228.0f/255.0f,142.0f/255.0f,57.0f/255.0f
-	};
-	static const GLfloat color_buffer_data3 [] = {
-		212.0f/255.0f,121.0f/255.0f,52.0f/255.0f,
-		212.0f/255.0f,121.0f/255.0f,52.0f/255.0f,
-		212.0f/255.0f,121.0f/255.0f,52.0f/255.0f,
-		212.0f/255.0f,121.0f/255.0f,52.0f/255.0f,
-		212.0f/255.0f,121.0f/255.0f,52.0f/255.0f,
-		212.0f/255.0f,121.0f/255.0f,52.0f/255.0f
-	};
-	woodlogs[0] = create3DObject(GL_TRIANGLES, 6, GAME_WOOD_VERTICAL, vertex_buffer_data[0], color_buffer_data, GL_FILL, 0, 0, 25);
-	woodlogs[1] = create3DObject(GL_TRIANGLES, 6, GAME_WOOD_HORIZONTAL, vertex_buffer_data[1], color_buffer_data, 280, 130, 25, GL_FILL);
-	woodlogs[2] = create3DObject(GL_TRIANGLES, 6, GAME_WOOD_HORIZONTAL, vertex_buffer_data[2], color_buffer_data3, 310, 175, 25, GL_FILL);
-	woodlogs[3] = create3DObject(GL_TRIANGLES, 6, GAME_WOOD_VERTICAL, vertex_buffer_data[3], color_buffer_data3, 150, -200, 25, GL_FILL);
-	woodlogs[4] = create3DObject(GL_TRIANGLES, 6, GAME_WOOD_VERTICAL, vertex_buffer_data[4], color_buffer_data3, 90, -110, 25, GL_FILL);
-	woodlogs[5] = create3DObject(GL_TRIANGLES, 6, GAME_WOOD_VERTICAL, vertex_buffer_data[4], color_buffer_data3, 90, -210, 25, GL_FILL);
-
+	// The log the bird knocks over keeps its own mesh, the movable ones are instances of a tinted unit square
+	MeshBuilder mesh;
+	mesh.Quad(-woodsizex[0], -woodsizey[0], woodsizex[0], woodsizey[0], MeshBuilder::RGB(228,142,57));
+	woodlogMesh = create3DObject(mesh);
+
+	MeshBuilder unit;
+	unit.Quad(-1, -1, 1, 1, MeshBuilder::RGB(255,255,255));
+	woodlogUnitMesh = create3DObject(unit);
 }
 
 void createBackground(GLuint textureID){
@@ -1128,25 +668,9 @@ void createBackground(GLuint textureID){
 }
 
 void createCatapult(){
-	static const GLfloat vertex_buffer_data[] = {
-		-0.5, -4, 0,
-		-0.5, 4, 0,
-		0.5, -4, 0,
-
-		-0.5, 4, 0,
-		0.5, -4, 0,
-		0.5, 4, 0
-	};
-
-	static const GLfloat color_buffer_data[] = {
-		86.0f/255.0f,38.0f/255.0f,15.0f/255.0f,
-		86.0f/255.0f,38.0f/255.0f,15.0f/255.0f,
-		86.0f/255.0f,38.0f/255.0f,15.0f/255.0f,
-		86.0f/255.0f,38.0f/255.0f,15.0f/255.0f,
-		86.0f/255.0f,38.0f/255.0f,15.0f/255.0f,
-		86.0f/255.0f,38.0f/255.0f,15.0f/255.0f
-	};
-	catapult = create3DObject(GL_TRIANGLES, 2*3 ,GAME_WOOD_HORIZONTAL, vertex_buffer_data, color_buffer_data, 50, 200, 0, GL_FILL);
+	MeshBuilder mesh;
+	mesh.Quad(-0.5, -4, 0.5, 4, MeshBuilder::RGB(86,38,15));
+	catapult = create3DObject(mesh);
 }
 float camera_rotation_angle = 90;
 float rectangle_rotation = 0;
@@ -1163,539 +687,238 @@ void createtemp(){
 	};
 	 static const GLfloat color_buffer_data [] ={
 		 1,0,0,1,0,0,1,0,0};
-	temp = create3DObject(GL_TRIANGLES, 3 ,GAME_WOOD_HORIZONTAL, vertex_buffer_data, color_buffer_data, 50, 200, 0, GL_FILL);
+	temp = create3DObject(GL_TRIANGLES, 3, vertex_buffer_data, color_buffer_data, GL_FILL);
 }
 
 
-void RenderText(Shader &shader, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color){
-    // Activate corresponding render state	
-    shader.Use();
-    glUniform3f(glGetUniformLocation(shader.Program, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(xVAO);
-
-    // Iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++) 
-    {
-        Character ch = Characters[*c];
-
-        GLfloat xpos = x + ch.Bearing.x * scale;
-        GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
-
-        GLfloat w = ch.Size.x * scale;
-        GLfloat h = ch.Size.y * scale;
-        // Update VBO for each character
-        GLfloat vertices[6][4] = {
-            { xpos,     ypos + h,   0.0, 0.0 },            
-            { xpos,     ypos,       0.0, 1.0 },
-            { xpos + w, ypos,       1.0, 1.0 },
-
-            { xpos,     ypos + h,   0.0, 0.0 },
-            { xpos + w, ypos,       1.0, 1.0 },
-            { xpos + w, ypos + h,   1.0, 0.0 }           
-        };
-        // Render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // Update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, xVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // Be sure to use glBufferSubData and not glBufferData
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // Render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // Now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-        x += (ch.Advance >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
-    }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+/* Compile the text shader, rasterize the glyph atlas and set up the text batch */
+/* Called once from initGL, everything created here lives for the whole session */
+void initText(){
+    // Compile and setup the shader, distance field glyphs need their own fragment shader
+    textShader = new Shader("shaders/text.vs", textMode == FONT_SDF ? "shaders/text_sdf.frag" : "shaders/text.frag");
+
+    // Rasterize the font once into a single atlas texture, layout stays in 48px units either way
+    font = new Font("arial.ttf", 48, textMode);
+
+    // Streaming buffer that receives every glyph quad of a frame
+    textBatch = new TextBatch(font, textShader, *streamBuffer);
+
+    // Score and lives are laid out in this band of the world and rendered into a texture on change
+    hud = new HudLayer(-600, 600, 220, 300, pixelsPerUnit());
+    static const GLfloat vertex_buffer_data[] = {
+        -600, 220, 0,
+        -600, 300, 0,
+        600, 220, 0,
+
+        -600, 300, 0,
+        600, 220, 0,
+        600, 300, 0
+    };
+    static const GLfloat texture_buffer_data[] = {
+        0,0,
+        0,1,
+        1,0,
+
+        0,1,
+        1,0,
+        1,1
+    };
+    hudQuad = create3DTexturedObject(GL_TRIANGLES, 6, vertex_buffer_data, texture_buffer_data, hud->TextureID, GL_FILL);
 }
 
 
+/* The last two simulation states, draw() blends between them */
+SimSnapshot previousState, currentState;
 
-
-Shader initShaderText(){
-    glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
-
-    // Compile and setup the shader
-    Shader shader("shaders/text.vs", "shaders/text.frag");
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(1200), 0.0f, static_cast<GLfloat>(600));
-    shader.Use();
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-    // FreeType
-    FT_Library ft;
-    // All functions return a value different than 0 whenever an error occurred
-    if (FT_Init_FreeType(&ft))
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-
-    // Load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, "arial.ttf", 0, &face))
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-
-    // Set size to load glyphs as
-    FT_Set_Pixel_Sizes(face, 0, 48);
-
-    // Disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
-
-    // Load first 128 characters of ASCII set
-    for (GLubyte c = 0; c < 128; c++){
-        // Load character glyph 
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)){
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-            continue;
-        }
-        // Generate texture
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-        // Set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        // Now store character for later use
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
-        };
-        Characters.insert(std::pair<GLchar, Character>(c, character));
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    // Destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-
-	
-    // Configure VAO/VBO for texture quads
-    glGenVertexArrays(1, &xVAO);
-    glGenBuffers(1, &xVBO);
-    glBindVertexArray(xVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, xVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-	Matrices.projection = glm::ortho(screenleft, screenright, screenbotton, screentop, 1.0f, 500.0f);
-	Matrices.view = glm::lookAt(glm::vec3(0,0,3), glm::vec3(0,0,0), glm::vec3(0,1,0));
- 	glm::mat4 VP = Matrices.projection * Matrices.view;
-	Matrices.model = glm::mat4(1.0f);
- 	glm::mat4 scaletext =  glm::scale(
-								glm::mat4(0.5f),
-							    glm::vec3(1.0f,-1.0f,0.0f));
-	Matrices.model*=scaletext;
-	glm::mat4 MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.TexMatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-	return shader;
+double lerp(double a, double b, double t){
+	return a + (b-a)*t;
 }
 
+/* Interpolates an angle in radians along the shortest arc */
+double lerpAngle(double a, double b, double t){
+	double d = fmod(b - a + 3*M_PI, 2*M_PI) - M_PI;
+	return a + d*t;
+}
 
-void draw ()
-{
-	// clear the color and depth in the frame buffer
-	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-
-	// use the loaded shader program
-	// Don't change unless you know what you are doing
-	glUseProgram (programID);
-
-	// Eye - Location of camera. Don't change unless you are sure!!
-	glm::vec3 eye ( 5*cos(camera_rotation_angle*M_PI/180.0f), 0, 5*sin(camera_rotation_angle*M_PI/180.0f) );
-	// Target - Where is the camera looking at.  Don't change unless you are sure!!
-	glm::vec3 target (0, 0, 0);
-	// Up - Up vector defines tilt of camera.  Don't change unless you are sure!!
-	glm::vec3 up (0, 1, 0);
-
-	// Compute Camera matrix (view)
-	//Matrices.view = glm::lookAt( eye, target, up ); // Rotating Camera for 3D
-	//  Don't change unless you are sure!!
-	Matrices.view = glm::lookAt(glm::vec3(0,0,3), glm::vec3(0,0,0), glm::vec3(0,1,0)); // Fixed camera for 2D (ortho) in XY plane
-
-	// Compute ViewProject matrix as view/camera might not be changed for this frame (basic scenario)
-	//  Don't change unless you are sure!!
-	glm::mat4 VP = Matrices.projection * Matrices.view;
-
-	// Send our transformation to the currently bound shader, in the "MVP" uniform
-	// For each model you render, since the MVP will be different (at least the M part)
-	//  Don't change unless you are sure!!
-	glm::mat4 MVP;	// MVP = Projection * View * Model
-
-	
-	//Displaying background using texture
-	glUseProgram(textureProgramID);
-
-	Matrices.model = glm::mat4(1.0f);
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.TexMatrixID, 1, GL_FALSE, &MVP[0][0]);
-	glUniform1i(glGetUniformLocation(textureProgramID, "texSampler"), 0);
-	draw3DTexturedObject(background);
-	
-	
-	glUseProgram (programID);
-	// Load identity to model matrix
-	Matrices.model = glm::mat4(1.0f);
+/* Back to front, overlapping objects must be in different layers, see RenderQueue.h */
+enum RenderLayer {
+	LAYER_BACKGROUND,
+	LAYER_PIGS,
+	LAYER_SCENERY,      // floor, power board and the wood log hit by the bird
+	LAYER_WOODLOGS,     // the movable wood logs
+	LAYER_SLING_BACK,
+	LAYER_BIRD,
+	LAYER_BIRD_BEAK,
+	LAYER_FRONT,        // front band of the sling and the power bar
+	LAYER_HUD           // drawn by the text pass
+};
 
-	/* Render your scene */
+/* Queue one arena object, textured objects use the texture program and the others the plain color one */
+void submit(int layer, VAO* vao, const glm::mat4 &model = glm::mat4(1.0f)){
+	GLuint program = vao->TextureID ? textureProgramID : programID;
+	renderQueue->Submit(layer, program, model, vao->PrimitiveMode, vao->Range, vao->FillMode, vao->TextureID);
+}
 
-	//glm::mat4 translateTriangle = glm::translate (glm::vec3(-2.0f, 0.0f, 0.0f)); // glTranslatef
-	//glm::mat4 rotateTriangle = glm::rotate((float)(triangle_rotation*M_PI/180.0f), glm::vec3(0,0,1));  // rotate about vector (1,0,0)
-	//glm::mat4 triangleTransform = translateTriangle * rotateTriangle;
-	//  Matrices.model *= triangleTransform; 
-	MVP = VP * Matrices.model; // MVP = p * V * M
+void submitBackground(){
+	submit(LAYER_BACKGROUND, background);
+}
 
-	//  Don't change unless you are sure!!
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	// draw3DObject draws the VAO given to it using current MVP matrix
-	//  draw3DObject(triangle);
-
-	// Pop matrix to undo transformations till last push matrix instead of recomputing model matrix
-	// glPopMatrix ();
-	//Displaying pigs and counting them for score 
-	int cnt = 0;
+/* Pigs roll as they move, as meshes each pig goes to the batch of the level of detail its on-screen size needs */
+void submitPigs(double alpha){
+	const SimSnapshot &prev = previousState, &cur = currentState;
 	for(int i=0;i<6;i++){
-		if(!pigs[i]->dead){
-			double x1 = cannonball[poscannonball]->centerx,y1 = cannonball[poscannonball]->centery, x2 = pigs[i]->centerx, y2 = pigs[i]->centery;
-			if(pigs[i]->radius + cannonball[poscannonball]->radius > sqrt((x2-x1)*(x2-x1)+(y2-y1)*(y2-y1))){
-				pigs[i]->dead = 1;
-				scoretimer[i][0] = pigs[i]->centerx; 
-				scoretimer[i][1] = pigs[i]->centery; 
-				scoretimer[i][2] = tim;
-				speedx = 0.1*speedx;
-				speedy = 0.1*speedy;
+		if(!pigs[i].dead){
+			double x = lerp(prev.pigx[i], cur.pigx[i], alpha), y = lerp(prev.pigy[i], cur.pigy[i], alpha);
+			double angle = (x-piginitx[i])/pigs[i].radius;
+			if(meshShapes){
+				int lod = ShapeLod(max(pigsizea[i], pigsizeb[i]) * pixelsPerUnit());
+				pigInstances[lod]->Add(x, y, angle, pigsizea[i], pigsizeb[i]);
 			}
-
-			Matrices.model = glm::mat4(1.0f);
-			glm::mat4 translatePig = glm::translate(glm::vec3(pigs[i]->centerx + pigspx[i],pigs[i]->centery + pigspy[i],0));
-			pigs[i]->centerx += pigspx[i];
-			pigs[i]->centery += pigspy[i];
-			glm::mat4 rotatePig = glm::rotate((float)((pigs[i]->centerx-piginitx[i])/pigs[i]->radius),glm::vec3(0,0,1));
-			pigspx[i]/= 1.02;
-			Matrices.model *= (translatePig*rotatePig);
-			MVP = VP  * Matrices.model; 
-			glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-			draw3DObject(pigs[i]);
-
+			else
+				pigEllipses->Shape(pigParts, x, y, angle, pigsizea[i], pigsizeb[i]);
 		}
-		else
-			cnt++;
 	}
+	if(meshShapes)
+		renderQueue->SubmitBatch(LAYER_PIGS, instancedProgramID, [](){
+			for(int lod=0; lod<SHAPE_LODS; lod++)
+				pigInstances[lod]->Draw();
+		});
+	else
+		renderQueue->SubmitBatch(LAYER_PIGS, shapeProgramID, [](){ drawShapes(pigEllipses); });
+}
 
-	//Displaying game floor
-	Matrices.model = glm::mat4(1.0f);
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	draw3DObject(gameFloor);
-	
-	//Displaying power board
-	Matrices.model = glm::mat4(1.0f);
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	draw3DObject(powerboard);
-
-	//Checking collisions between pigs and wood logs
-	Matrices.model = glm::mat4(1.0f);
-	glm::mat4 translateWoodlog,rotateWoodlog;
-	translateWoodlog = glm::translate(glm::vec3(0,170,0));
+/* The floor, the power board and the wood logs, the one hit by the bird rotates around its bottom corner */
+void submitScenery(double alpha){
+	const SimSnapshot &prev = previousState, &cur = currentState;
+	submit(LAYER_SCENERY, gameFloor);
+	submit(LAYER_SCENERY, powerboard);
+
+	glm::mat4 model;
 	if(collision_state==1){
-		if(pivotx == -10){
-			translateWoodlog = glm::translate(glm::vec3(10,200,0));
-			glm::mat4 translateWoodlog2 = glm::translate(glm::vec3(pivotx,pivoty,0));
-			rotateWoodlog = glm::rotate((float)(angle[0]*M_PI/180.0f), glm::vec3(0,0,1));
-			angle[0] += angular_v[0];
-			angular_v[0] += 0.3;
-			angle[0] = min(angle[0],90.0);
-			Matrices.model *= (translateWoodlog*rotateWoodlog*translateWoodlog2);
-			if(angle[0] >= 45){
-				pigs[0]->dead = 1;
-				scoretimer[0][0]=pigs[0]->centerx;
-				scoretimer[0][1]=pigs[0]->centery;
-				scoretimer[0][2]=tim;
-			}
-		}
-		else{
-			translateWoodlog = glm::translate(glm::vec3(-10,200,0));
-			glm::mat4 translateWoodlog2 = glm::translate(glm::vec3(pivotx,pivoty,0));
-			rotateWoodlog = glm::rotate((float)(angle[0]*M_PI/180.0f), glm::vec3(0,0,1));
-			angle[0] -= angular_v[0];
-			angular_v[0] += 0.3;
-			angle[0] = max(angle[0],-90.0);
-			Matrices.model *= (translateWoodlog*rotateWoodlog*translateWoodlog2);
-			if(angle[0] >= 45){
-				pigs[0]->dead = 1;
-				scoretimer[0][0]=pigs[0]->centerx;
-				scoretimer[0][1]=pigs[0]->centery;
-				scoretimer[0][2]=tim;
-			}
-		}
+		glm::mat4 translateWoodlog = glm::translate(glm::vec3(pivotx == -10 ? 10 : -10,200,0));
+		glm::mat4 translateWoodlog2 = glm::translate(glm::vec3(pivotx,pivoty,0));
+		glm::mat4 rotateWoodlog = glm::rotate((float)(lerp(prev.logangle, cur.logangle, alpha)*M_PI/180.0f), glm::vec3(0,0,1));
+		model = translateWoodlog*rotateWoodlog*translateWoodlog2;
 	}
 	else
-		Matrices.model *= translateWoodlog;
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	draw3DObject(woodlogs[0]);
+		model = glm::translate(glm::vec3(0,170,0));
+	submit(LAYER_SCENERY, woodlogMesh, model);
 
-	//Displaying wood logs
 	for(int i=1;i<=5;i++){
-		Matrices.model = glm::mat4(1.0f);
-		translateWoodlog = glm::translate(glm::vec3(woodlogs[i]->centerx + woodspx[i],woodlogs[i]->centery,0));
-		woodlogs[i]->centerx += woodspx[i];
-		woodspx[i] /= 1.02;
-		Matrices.model *= translateWoodlog;
-		MVP = VP * Matrices.model;
-		glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-		draw3DObject(woodlogs[i]);
-		if(i<=2&&woodlogs[i]->centerx + woodsizex[i] > pigs[i]->centerx - pigs[i]->radius){
-			pigspx[i] = woodspx[i]*0.95;
-			woodspx[i]=woodspx[i]*0.9;
-			pigs[i]->centerx = woodlogs[i]->centerx + woodsizex[i] + pigs[i]->radius;
-		}
-	}
-
-	//Checking collisions between pigs and pigs
-	for(int i=0;i<4;i++) {
-		if(pig_wood[i]!=0){
-			int j = pig_wood[i];
-			
-			if(j==1){
-				if(pigs[i]->centerx+pigs[i]->radius<woodlogs[j]->centerx - woodsizex[j])
-					pigspy[i]+=gravity/3.0f;
-				if((pigs[i]->centery+pigs[i]->radius > woodlogs[j+1]->centery - woodsizey[j+1])
-						||pigs[i]->centery + pigs[i]->radius > 200){
-					pigs[i]->dead=1;
-					scoretimer[i][0] = pigs[i]->centerx; 
-					scoretimer[i][1] = pigs[i]->centery; 
-					scoretimer[i][2] = tim;
-				}
-
-			}
-			if(j==2){
-				if(pigs[i]->centerx-pigs[i]->radius>woodlogs[j]->centerx + woodsizex[j])
-					pigspy[i]+=gravity/3.0f;
-				double x1 = pigs[i]->centerx, y1 = pigs[i]->centery, x2 = pigs[i+1]->centerx, y2 = pigs[i+1]->centery;
-				if(sqrt((x1-x2)*(x1-x2)+(y1-y2)*(y1-y2)) < pigs[i]->radius + pigs[i+1]->radius)
-				{
-					pigs[i]->dead=pigs[i+1]->dead = 1;
-					scoretimer[i][0] = pigs[i]->centerx; 
-					scoretimer[i][1] = pigs[i]->centery; 
-					scoretimer[i][2]=tim;
-					scoretimer[i+1][0] = pigs[i+1]->centerx; 
-					scoretimer[i+1][1] = pigs[i+1]->centery; 
-					scoretimer[i+1][2]=tim;
-				}
-				if(pigs[i]->centery+pigs[i]->radius>200){
-					pigs[i]->dead=1;
-					scoretimer[i][0] = pigs[i]->centerx; 
-					scoretimer[i][1] = pigs[i]->centery; 
-					scoretimer[i][2]=tim;
-				}
-				
-			}
-		}
+		glm::vec3 tint = i == 1 ? MeshBuilder::RGB(228,142,57) : MeshBuilder::RGB(212,121,52);
+		woodlogInstances->Add(lerp(prev.woodx[i], cur.woodx[i], alpha), lerp(prev.woody[i], cur.woody[i], alpha), 0, woodsizex[i], woodsizey[i], tint);
 	}
+	renderQueue->SubmitBatch(LAYER_WOODLOGS, instancedProgramID, [](){
+		woodlogInstances->Draw();
+	});
+}
 
-	//Controlling bird using keyboard
-	if(keyboard_pressed_statex == 1){
-		keyboardy -= 2;
-		if(keyboardx < fireposx)
-			keyboardx += 2;
-		else if(keyboardx > fireposx)
-			keyboardx -= 2;
-		curx = keyboardx;
-		cury = keyboardy;
-	}
-	if(keyboard_pressed_statey == 1){
-		keyboardy += 2;
-		if(keyboardx < fireposx)
-			keyboardx -=2;
-		else if(keyboardx >fireposx)
-			keyboardx += 2;
-		curx = keyboardx;
-		cury = keyboardy;
-	}
-		
-	//Limiting the power with which bird can be shot
-	if(pressed_state==1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1)
-		if(sqrt((curx-initx)*(curx-initx)+(cury-inity)*(cury-inity)) > 70){
-			double angle_present = -M_PI+atan2(inity-cury,initx-curx);
-			curx = initx + 70*cos(angle_present);
-			cury = inity + 70*sin(angle_present);
-		}
-	
-	//Displaying catapult
-	Matrices.model = glm::mat4(1.0f);
-	glm::mat4 translateCatapult = glm::translate(glm::vec3(-0.5, -4, 0));
-	glm::mat4 translateCatapult2 = glm::translate(glm::vec3(fireposx-10 , fireposy+10 , 0));
-	glm::mat4 rotateCatapult = glm::rotate((float)(atan2(-cury+fireposy+10 ,-curx+fireposx-10)), glm::vec3(0,0,1));
-	double scalelength2 = sqrt((fireposx-10 - curx)*(fireposx -10 -curx) + (fireposy+10 - cury)*(fireposy+10-cury));
-	glm::mat4 scaleCatapult = glm::scale(glm::vec3(scalelength2 , 1, 1));
-	if(pressed_state == 1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1)
-		Matrices.model *= (translateCatapult2 * rotateCatapult *  scaleCatapult * translateCatapult);
-	else
-		Matrices.model *= translateCatapult;
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	if(pressed_state==1)
-		draw3DObject(catapult);
-
-	//Displaying the bird
-	Matrices.model = glm::mat4(1.0f);
-	glm::mat4 translateRectangle;// = glm::translate (glm::vec3(curx, cury, 0));        // glTranslatef
-	glm::mat4 rotateRectangle; // rotate about vector (-1,1,1)
-	if(pressed_state==0 && keyboard_pressed_statex == 0 && keyboard_pressed_statey == 0){
-		translateRectangle = glm::translate (glm::vec3(fireposx, fireposy, 0));        // glTranslatef
-		//cout<<"iniciooooo "<<lives<<endl;
-		cannonball[poscannonball]->centerx = fireposx;
-		cannonball[poscannonball]->centery = fireposy;
-		cannonball[poscannonball]->radius = cannonball_size;
-
-		if(lives<=2){
-			poscannonball=1;
-			cannonball[poscannonball]->centerx = fireposx;
-			cannonball[poscannonball]->centery = fireposy;
-			cannonball[poscannonball]->radius = cannonball_size;
-		}	
-	}
-	else if(pressed_state==1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1){
-		if(sqrt((curx-initx)*(curx-initx)+(cury-inity)*(cury-inity)) > 70){
-			double angle_present = -M_PI+atan2(inity-cury,initx-curx);
-			curx = initx + 70*cos(angle_present);
-			cury = inity + 70*sin(angle_present);
-		}
-		power = sqrt((curx-initx)*(curx-initx) + (cury-inity)*(cury-inity));
-		translateRectangle = glm::translate (glm::vec3(curx, cury, 0));        // glTranslatef
-		cannonball[poscannonball]->centerx = curx;
-		cannonball[poscannonball]->centery = cury;
-		cannonball[poscannonball]->radius = cannonball_size;
-	}
-	else {
-		translateRectangle = glm::translate (glm::vec3(initx, inity, 0));        // glTranslatef
-		cannonball[poscannonball]->centerx = initx;
-		cannonball[poscannonball]->centery = inity;
-		cannonball[poscannonball]->radius = cannonball_size;
-	}
-	if(collision_state == 0 && cannonball[poscannonball]->centerx >= -10 - cannonball_size && cannonball[poscannonball]->centerx <= -10 + 20 + cannonball_size && cannonball[poscannonball]->centery >= 140 - cannonball_size ){
-		collision_state=1;
-		angle[0] = 0.1;
-		angular_v[0] = speedx*0.2;
-		if(cannonball[poscannonball]->centerx > 10){
-			pivotx = 10;
-			angle[0] = -0.1;
-			angular_v[0] = -speedx*0.2;
-		}
-		if(cannonball[poscannonball]->centery < 140 && cannonball[poscannonball]->centerx > -10 - cannonball_size/2 && (cannonball[poscannonball]->centerx < 10 + cannonball_size/2)){
-			speedy = -0.5*speedy;
-			inity = 140 - cannonball_size - 1;
-		}
-		else{
-			speedx = -0.5*speedx;
-		}
+/* One band of the sling, stretched from its post at (postx, posty) to the bird while it is pulled */
+void submitSlingBand(int layer, double postx, double posty){
+	glm::mat4 model = glm::translate(glm::vec3(-0.5, -4, 0));
+	if(pressed_state == 1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1){
+		glm::mat4 translatePost = glm::translate(glm::vec3(postx, posty, 0));
+		glm::mat4 rotateBand = glm::rotate((float)(atan2(-cury+posty, -curx+postx)), glm::vec3(0,0,1));
+		double length = sqrt((postx - curx)*(postx - curx) + (posty - cury)*(posty - cury));
+		model = translatePost * rotateBand * glm::scale(glm::vec3(length, 1, 1)) * model;
 	}
+	if(pressed_state == 1)
+		submit(layer, catapult, model);
+}
 
-	for(int i=1;i<=5;i++){
-		double x = cannonball[poscannonball]->centerx,y = cannonball[poscannonball]->centery;
-		if(x >= woodlogs[i]->centerx - woodsizex[i] - cannonball_size && x <= woodlogs[i]->centerx + woodsizex[i] + cannonball_size && y >= woodlogs[i]->centery - woodsizey[i] - cannonball_size && y <= woodlogs[i]->centery + woodsizey[i]) {
-			if(cannonball[poscannonball]->centery < woodlogs[i]->centery - woodsizey[i] && cannonball[poscannonball]->centerx > woodlogs[i]->centerx - woodsizex[i] - cannonball_size/2 ){
-				speedy = -0.25*speedy, speedx = 0.25*speedx;
-				inity = woodlogs[i]->centery - woodsizey[i] - cannonball_size - 1;
-			}
-			else {
-				if(i==1){
-					woodspx[1] = speedx * 0.1;
-					woodspx[2] = woodspx[1] * 0.1;
-				}
-				else if(i==2){
-					woodspx[2] = speedx * 0.05;
-					woodspx[1] = woodspx[2] * 0.5;
-				}
-				speedx = -0.25*speedx, speedy = 0.25*speedy;
-				initx = woodlogs[i]->centerx - woodsizex[i] - cannonball_size - 1;
-			}
-			break;
-		}
+void submitBird(double alpha){
+	const SimSnapshot &prev = previousState, &cur = currentState;
+	// Blending across a jump back to the sling would draw the bird sliding through the level
+	if(cur.birdjumped)
+		alpha = 1;
+	double x = lerp(prev.birdx, cur.birdx, alpha), y = lerp(prev.birdy, cur.birdy, alpha);
+	double angle = lerpAngle(prev.birdangle, cur.birdangle, alpha);
+	glm::mat4 model = glm::translate(glm::vec3(x, y, 0)) * glm::rotate((float)angle, glm::vec3(0,0,1));
+	if(meshShapes)
+		submit(LAYER_BIRD, birdMesh[poscannonball][ShapeLod(cannonball[poscannonball].radius * pixelsPerUnit())], model);
+	else{
+		// Body, eye and pupil as ellipses, the beak stays a triangle on top of them
+		birdEllipses->Shape(poscannonball ? bigBirdParts : smallBirdParts, x, y, angle);
+		renderQueue->SubmitBatch(LAYER_BIRD, shapeProgramID, [](){ drawShapes(birdEllipses); });
+		submit(LAYER_BIRD_BEAK, beakMesh[poscannonball], model);
 	}
-	if(pressed_state==3) 
-		rotateRectangle = glm::rotate((float)(atan2(-prevy+inity,-prevx+initx)), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-	else
-		rotateRectangle = glm::rotate((float)(atan2(-cury+inity,-curx+initx)), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-
-	if(pressed_state==3 || pressed_state==1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey)  Matrices.model *= (translateRectangle * rotateRectangle);
-	else  Matrices.model *= (translateRectangle );
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-	// draw3DObject draws the VAO given to it using current MVP matrix
-	draw3DObject(cannonball[poscannonball]);
-
-
-	//Displaying power
-	Matrices.model = glm::mat4(1.0f);
-	translateCatapult = glm::translate(glm::vec3(-0.5, -4, 0));
-	translateCatapult2 = glm::translate(glm::vec3(fireposx + 20, fireposy + 15, 0));
-	rotateCatapult = glm::rotate((float)(atan2(-cury+fireposy + 15,-curx+fireposx + 20)), glm::vec3(0,0,1));
-	double scalelength = sqrt((fireposx+20 - curx)*(fireposx + 20 -curx) + (fireposy+15 - cury)*(fireposy+15-cury));
-	scaleCatapult = glm::scale(glm::vec3(scalelength , 1, 1));
-	if(pressed_state == 1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1)
-		Matrices.model *= (translateCatapult2 * rotateCatapult *  scaleCatapult * translateCatapult);
-	else
-		Matrices.model *= translateCatapult;
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	if(pressed_state ==1) draw3DObject(catapult);
+}
 
-	Matrices.model = glm::mat4(1.0f);
+void submitPower(){
 	glm::mat4 scalePower = glm::scale(glm::vec3(power*6,1,1));
 	glm::mat4 translatePower = glm::translate(glm::vec3(-400 - ( 90 - power * 3), -240, 0));
-	Matrices.model *= ( translatePower * scalePower);
-	MVP = VP * Matrices.model;
-	glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	draw3DObject(powerelement);
-
-
-	// Increment angles
-	float increments = 1;
-
-	if(pressed_state==3){
-		prevx=initx,prevy=inity;
-		initx=initx+speedx,inity=inity+speedy,speedy+=gravity;
-		inity=min(200-cannonball_size,inity);
-		if(inity==200-cannonball_size)
-			speedy=-0.8*speedy,speedx=0.7*speedx;
-		if(fabs(speedx)<=0.05&&fabs(speedy)<=0.05){
-				pressed_state=0;
-				gravity = 0.2;
-				power = 0;
-			
-		}
+	submit(LAYER_FRONT, powerelement, translatePower * scalePower);
+}
+
+/* Render the scene, alpha in [0,1] is how far we are between the last two simulation ticks */
+/* Every part of the world submits its draws to the render queue, which sorts them by layer and state */
+void draw (double alpha)
+{
+	// clear the color and depth in the frame buffer
+	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Compute Camera matrix (view)
+	//Matrices.view = glm::lookAt( eye, target, up ); // Rotating Camera for 3D
+	//  Don't change unless you are sure!!
+	Matrices.view = glm::lookAt(glm::vec3(0,0,3), glm::vec3(0,0,0), glm::vec3(0,1,0)); // Fixed camera for 2D (ortho) in XY plane
+
+	// Compute ViewProject matrix as view/camera might not be changed for this frame (basic scenario)
+	//  Don't change unless you are sure!!
+	glm::mat4 VP = Matrices.projection * Matrices.view;
+	camera->Update(VP, 1.0 / pixelsPerUnit());
+
+	gpuTimer->Begin(GPU_PASS_BACKGROUND);
+	submitBackground();
+	renderQueue->Flush();
+	gpuTimer->End(GPU_PASS_BACKGROUND);
+
+	gpuTimer->Begin(GPU_PASS_WORLD);
+	submitPigs(alpha);
+	submitScenery(alpha);
+	submitSlingBand(LAYER_SLING_BACK, fireposx-10, fireposy+10);
+	submitBird(alpha);
+	submitSlingBand(LAYER_FRONT, fireposx+20, fireposy+15);
+	submitPower();
+	renderQueue->Flush();
+	// The HUD redraw in the text pass draws filled
+	GlState::Instance().PolygonMode(GL_FILL);
+	gpuTimer->End(GPU_PASS_WORLD);
+}
+
+/* Render the score and lives on top of the world */
+void drawText ()
+{
+	gpuTimer->Begin(GPU_PASS_TEXT);
+
+	// The HUD texture is only redrawn when what it shows or the zoom has changed,
+	// it is composited through the world camera so it needs as many texels per unit as the framebuffer
+	hud->SetPixelsPerUnit(pixelsPerUnit());
+	if(score != hudscore || lives != hudlives){
+		hudscore = score;
+		hudlives = lives;
+		hud->Invalidate();
+	}
+	if(hud->NeedsRedraw()){
+		string initextscore="Score: ";
+		string initextlives="Lives: ";
+
+		hud->BeginRedraw();
+		textBatch->Add(initextscore+tos(score), 350.0f, 250.0f, 0.5f, glm::vec3(0.8f, 0.5f, 0.6f));
+		textBatch->Add(initextlives+tos(lives), -550.0f, 265.0f, 0.5f, glm::vec3(1.0f, 0.0f, 0.0f));
+		textBatch->Flush(hud->Projection);
+		hud->EndRedraw();
 	}
 
-	score = cnt * 100;
-	Shader shader=initShaderText();
-	string initextscore="Score: ";
-	string initextlives="Lives: ";
+	// Text is laid out in world units with y pointing up, so flip it into the y-down world camera
+	GlState &gl = GlState::Instance();
+	gl.Enable(GL_BLEND);
+	gl.BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	submit(LAYER_HUD, hudQuad, glm::scale(glm::vec3(1.0f, -1.0f, 1.0f)));
+	renderQueue->Flush();
+	gl.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	gl.Disable(GL_BLEND);
 
-	RenderText(shader, initextscore+tos(score), 350.0f, 250.0f, 0.5f, glm::vec3(0.8f, 0.5f, 0.6f));
-	RenderText(shader, initextlives+tos(lives), -550.0f, 265.0f, 0.5f, glm::vec3(1.0f, 0.0f, 0.0f));
-	glDisable(GL_BLEND);
+	gpuTimer->End(GPU_PASS_TEXT);
 }
 
 /* Initialise glfw window, I/O callbacks and the renderer to use */
@@ -1722,7 +945,6 @@ GLFWwindow* initGLFW (int width, int height){
 
 	glfwMakeContextCurrent(window);
 	gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-	glfwSwapInterval( 1 );
 
 	/* --- register callbacks with GLFW --- */
 
@@ -1755,24 +977,42 @@ void initGL (GLFWwindow* window, int width, int height){
 	
 	// load an image file directly as a new OpenGL texture
 	// GLuint texID = SOIL_load_OGL_texture ("beach.png", SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, SOIL_FLAG_TEXTURE_REPEATS); // Buggy for OpenGL3
-	GLuint textureID = createTexture("background.png");
+	backgroundTexture = createTexture("background.png");
 	
 	// check for an error during the load process
-	if(textureID == 0 )
+	if(backgroundTexture == 0 )
 		cout << "SOIL loading error: '" << SOIL_last_result() << "'" << endl;
 
+	// Everything written per frame goes through one ring buffer
+	streamBuffer = new StreamBuffer();
+
+	// Camera and model matrices come from uniform buffers shared by every world program
+	camera = new CameraUniforms(*streamBuffer);
+
 	// Create and compile our GLSL program from the texture shaders
-	textureProgramID = LoadShaders( "TextureRender.vert", "TextureRender.frag" );
-	// Get a handle for our "MVP" uniform
-	Matrices.TexMatrixID = glGetUniformLocation(textureProgramID, "MVP");
+	textureProgramID = GpuProgram(LoadShaders( "TextureRender.vert", "TextureRender.frag" ));
+	BindUniformBlocks(textureProgramID);
+	// Textures are always read from unit 0
+	GlState::Instance().UseProgram(textureProgramID);
+	glUniform1i(glGetUniformLocation(textureProgramID, "texSampler"), 0);
+
 
+	// Place the level first, the meshes are sized from it
+	setupLevel();
+
+	// Every mesh created below is packed into this one buffer
+	worldMeshes = new MeshArena();
 
 	/* Objects should be created before any other gl function and shaders */
 	// Create the models
 	// Generate the VAO, VBOs, vertices data & copy into the array buffer
-	createBackground (textureID);
-	createCannonball ();
-	createCannonball2 ();
+	createBackground (backgroundTexture);
+	for(int lod=0; lod<SHAPE_LODS; lod++){
+		birdMesh[0][lod] = create3DObject(smallBirdShapes[lod]);
+		birdMesh[1][lod] = create3DObject(bigBirdShapes[lod]);
+	}
+	beakMesh[0] = create3DObject(smallBeakShape);
+	beakMesh[1] = create3DObject(bigBeakShape);
 	createGameFloor ();
 	createWoodLogs();
 	createPig();
@@ -1781,12 +1021,36 @@ void initGL (GLFWwindow* window, int width, int height){
 	createCatapult();
 	createtemp();
 
+	// Text shader and glyph atlas are built once and shared by every frame
+	initText();
+
+	// All meshes exist now, send them to the GPU in one go
+	worldMeshes->Upload();
+
+	// Every draw of the world pass goes through the queue
+	renderQueue = new RenderQueue(*worldMeshes, *streamBuffer);
+
+	// Pigs and movable wood logs are drawn one instanced call per kind
+	for(int lod=0; lod<SHAPE_LODS; lod++)
+		pigInstances[lod] = new InstanceBatch(*worldMeshes, *streamBuffer, pigMesh[lod]->Range);
+	woodlogInstances = new InstanceBatch(*worldMeshes, *streamBuffer, woodlogUnitMesh->Range);
+	instancedProgramID = GpuProgram(LoadShaders( "Instanced_GL.vert", "Sample_GL.frag" ));
+	BindUniformBlocks(instancedProgramID);
+
+	// Round objects as one quad per ellipse
+	pigEllipses = new ShapeBatch(*streamBuffer);
+	birdEllipses = new ShapeBatch(*streamBuffer);
+	shapeProgramID = GpuProgram(LoadShaders( "Shape_GL.vert", "Shape_GL.frag" ));
+	BindUniformBlocks(shapeProgramID);
+
+	// GPU time of the background, world and text passes
+	gpuTimer = new GpuTimer();
+
 	//createCatapult2();
 
 	// Create and compile our GLSL program from the shaders
-	programID = LoadShaders( "Sample_GL.vert", "Sample_GL.frag" );
-	// Get a handle for our "MVP" uniform
-	Matrices.MatrixID = glGetUniformLocation(programID, "MVP");
+	programID = GpuProgram(LoadShaders( "Sample_GL.vert", "Sample_GL.frag" ));
+	BindUniformBlocks(programID);
 
 
 	reshapeWindow (window, width, height);
@@ -1795,7 +1059,7 @@ void initGL (GLFWwindow* window, int width, int height){
 	glClearColor(156.0/255.0f,205.0f/255.0f,237.0f/255.0f,0.0f);// (0.3f, 0.3f, 0.3f, 0.0f); // R, G, B, A
 	glClearDepth (1.0f);
 
-	glEnable (GL_DEPTH_TEST);
+	GlState::Instance().Enable(GL_DEPTH_TEST);
 	glDepthFunc (GL_LEQUAL);
 	
 	// Initialise FTGL stuff
@@ -1810,10 +1074,50 @@ int main (int argc, char** argv){
 	int width = 1200;
 	int height = 600;
 
+	// Frame pacing: --vsync (default), --fps N for a fixed target rate, --uncapped for benchmarking
+	for(int i=1;i<argc;i++){
+		if(!strcmp(argv[i], "--vsync"))
+			framePacer.mode = FramePacer::VSYNC;
+		else if(!strcmp(argv[i], "--uncapped"))
+			framePacer.mode = FramePacer::UNCAPPED;
+		else if(!strcmp(argv[i], "--fps") && i+1<argc){
+			framePacer.mode = FramePacer::TARGET_FPS;
+			framePacer.interval = 1.0/max(atof(argv[++i]), 1.0);
+		}
+		// Per-phase frame timings are written here on exit or F12, .json for JSON and CSV otherwise
+		else if(!strcmp(argv[i], "--timings") && i+1<argc)
+			timingsPath = argv[++i];
+		// Distance field text is the default, plain coverage bitmaps are kept for comparison
+		else if(!strcmp(argv[i], "--bitmap-text"))
+			textMode = FONT_BITMAP;
+		// Prebaked assets made by `make bundle`, anything missing from it is loaded from its source file
+		else if(!strcmp(argv[i], "--bundle") && i+1<argc)
+			bundlePath = argv[++i];
+		// Tessellated pigs and birds instead of analytic ellipses, for comparison
+		else if(!strcmp(argv[i], "--mesh-shapes"))
+			meshShapes = true;
+	}
+
+	// Mapped before anything is loaded, the glyph cache keeps reading from it while the game runs
+	if(AssetBundle::Instance().Open(bundlePath.c_str()))
+		cout << "Assets: " << AssetBundle::Instance().Count() << " from " << bundlePath << endl;
+
 	GLFWwindow* window = initGLFW(width, height);
 	initGL (window, width, height);
 
-	double last_update_time = glfwGetTime(), current_time;
+	// Only vsync mode lets the swap wait for the display, the others pace themselves
+	glfwSwapInterval(framePacer.mode == FramePacer::VSYNC ? 1 : 0);
+	if(framePacer.mode == FramePacer::VSYNC){
+		const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+		if(mode && mode->refreshRate > 0)
+			framePacer.interval = 1.0/mode->refreshRate;
+	}
+
+	// Run one tick so every object has a valid position before the first frame
+	simulate();
+	previousState = currentState = takeSnapshot();
+
+	double current_time, previous_time = glfwGetTime(), accumulator = 0;
 	
 	
 	pid = fork();
@@ -1871,8 +1175,11 @@ int main (int argc, char** argv){
 
 	/* Draw in loop */
 	while (!glfwWindowShouldClose(window)) {
+		frameProfiler.BeginFrame();
+		gpuTimer->BeginFrame(frameProfiler);
+		streamBuffer->BeginFrame();
 
-		
+		frameProfiler.Begin(PHASE_CAMERA);
 		if(panleft == 1 && screenleft >= -600 + 5){
 			screenleft -= 5;
 			screenright -= 5;
@@ -1908,36 +1215,54 @@ int main (int argc, char** argv){
 		}
 		if(zoominstate == 1 || zoomoutstate == 1 || panleft == 1 || panright == 1 || panup == 1 || pandown == 1)
 			reshapeWindow(window, width, height);
-		// OpenGL Dramands
-
-		draw();
+		frameProfiler.End(PHASE_CAMERA);
+
+		// Step the simulation at a fixed rate, as many ticks as the elapsed time asks for
+		// Frame time is clamped so a long stall doesn't trigger an endless catch-up
+		frameProfiler.Begin(PHASE_SIMULATION);
+		current_time = glfwGetTime();
+		accumulator += min(current_time - previous_time, 0.25);
+		previous_time = current_time;
+		while(accumulator >= SIM_TIMESTEP){
+			previousState = currentState;
+			simulate();
+			currentState = takeSnapshot();
+			accumulator -= SIM_TIMESTEP;
+		}
+		frameProfiler.End(PHASE_SIMULATION);
 
+		// OpenGL Dramands
+		frameProfiler.Begin(PHASE_DRAW);
+		draw(accumulator / SIM_TIMESTEP);
+		frameProfiler.End(PHASE_DRAW);
 
-		/*
-		reshapeWindow(window, width, height);
+		frameProfiler.Begin(PHASE_TEXT);
+		drawText();
+		frameProfiler.End(PHASE_TEXT);
+		streamBuffer->EndFrame();
 
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);		
-		RenderText(shader, "This is sample text", 25.0f, 25.0f, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        RenderText(shader, "(C) LearnOpenGL.com", 200.0f, 200.0f, 0.5f, glm::vec3(0.3, 0.7f, 0.9f));
-*/
-		for(int i=0;i<3000000;i++)4;
+		frameProfiler.Begin(PHASE_PACING);
+		framePacer.Wait();
+		frameProfiler.End(PHASE_PACING);
 
-		
 		// Swap Frame Buffer in double buffering
+		frameProfiler.Begin(PHASE_SWAP);
 		glfwSwapBuffers(window);
+		frameProfiler.End(PHASE_SWAP);
 
 		// Poll for Keyboard and mouse events
+		frameProfiler.Begin(PHASE_INPUT);
 		glfwPollEvents();
+		frameProfiler.End(PHASE_INPUT);
 
-		// Control based on time (Time based transformation like 5 degrees rotation every 0.5s)
-		current_time = glfwGetTime(); // Time in seconds
-		if ((current_time - last_update_time) >= 0.5) { // atleast 0.5s elapsed since last frame
-			// do something every 0.5 seconds ..
-			last_update_time = current_time;
-		}
+		GlState::Instance().EndFrame();
+		frameProfiler.SetGlCalls(GlState::Instance().Issued(), GlState::Instance().Filtered());
+		frameProfiler.EndFrame();
 	}
 
+	framePacer.Report(cout);
+	frameProfiler.Dump(timingsPath);
+	releaseGL();
 	glfwTerminate();
 	exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <iterator>
+
+#include <sys/stat.h>
+
+#include <SOIL/SOIL.h>
+
+#include "AssetBundle.h"
+#include "GlyphRasterizer.h"
+
+using namespace std;
+
+/* Bakes the game's assets into one bundle the game maps at startup instead of decoding them */
+/* Usage: ./packer [output]  (default assets.bundle, run from the game directory) */
+/* Images are stored decoded, shaders as their source text and fonts as prerasterized atlas glyphs */
+
+/* Everything initGL loads from disk, keep in sync with it */
+static const char* images[] = { "background.png" };
+static const char* shaders[] = {
+	"Sample_GL.vert", "Sample_GL.frag", "TextureRender.vert", "TextureRender.frag", "Instanced_GL.vert",
+	"Shape_GL.vert", "Shape_GL.frag",
+	"shaders/text.vs", "shaders/text.frag", "shaders/text_sdf.frag"
+};
+static const char* fontPath = "arial.ttf";
+static const int fontPixelSize = 48; // as requested by initText
+
+struct Asset {
+	string name;
+	vector<char> data;
+	struct stat source;
+};
+
+static vector<Asset> assets;
+
+static vector<char>& addAsset(const string &name){
+	if(name.size() >= sizeof(((BundleEntry*)0)->Name)){
+		cerr << "Asset name too long: " << name << endl;
+		exit(EXIT_FAILURE);
+	}
+	assets.push_back(Asset());
+	assets.back().name = name;
+	if(stat(BundleSourcePath(name).c_str(), &assets.back().source) != 0){
+		cerr << "Could not stat " << BundleSourcePath(name) << endl;
+		exit(EXIT_FAILURE);
+	}
+	return assets.back().data;
+}
+
+static void append(vector<char> &data, const void *bytes, size_t size){
+	data.insert(data.end(), (const char*)bytes, (const char*)bytes + size);
+}
+
+static bool packImage(const char* path){
+	int width, height;
+	unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB);
+	if(!image)
+		return false;
+	BakedImage header = { (uint32_t)width, (uint32_t)height, 3, 0 };
+	vector<char> &data = addAsset(path);
+	append(data, &header, sizeof(header));
+	append(data, image, (size_t)width * height * 3);
+	SOIL_free_image_data(image);
+	return true;
+}
+
+static bool packShader(const char* path){
+	ifstream file(path, ios::in | ios::binary);
+	if(!file.is_open())
+		return false;
+	vector<char> &data = addAsset(path);
+	data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	return true;
+}
+
+/* Printable ASCII and Latin-1, which covers the HUD; any other glyph is still rasterized at runtime */
+static bool packFont(const char* path, FontMode mode, int pixelSize){
+	GlyphRasterizer rasterizer(path, mode, pixelSize);
+	if(!rasterizer.IsOpen())
+		return false;
+	vector<BakedGlyph> glyphs;
+	vector<unsigned char> pixels;
+	for(uint32_t codepoint=0x20; codepoint<=0xFF; codepoint++){
+		if(codepoint >= 0x7F && codepoint < 0xA0)
+			continue;
+		GlyphImage image;
+		if(!rasterizer.Rasterize(codepoint, image))
+			continue;
+		BakedGlyph glyph = { codepoint, image.Width, image.Height, image.Left, image.Top, image.Advance, pixels.size() };
+		glyphs.push_back(glyph);
+		if(image.Pixels)
+			pixels.insert(pixels.end(), image.Pixels, image.Pixels + image.Width * image.Height);
+	}
+	// Pixel offsets are from the start of the asset
+	size_t pixelsStart = sizeof(BakedGlyphs) + glyphs.size() * sizeof(BakedGlyph);
+	for(size_t i=0; i<glyphs.size(); i++)
+		glyphs[i].Pixels += pixelsStart;
+
+	BakedGlyphs header = { (uint32_t)glyphs.size(), 0 };
+	vector<char> &data = addAsset(BakedFontName(path, mode == FONT_SDF, GlyphRasterizer::RasterSize(mode, pixelSize)));
+	append(data, &header, sizeof(header));
+	append(data, &glyphs[0], glyphs.size() * sizeof(BakedGlyph));
+	append(data, &pixels[0], pixels.size());
+	return true;
+}
+
+static size_t aligned(size_t offset){
+	return (offset + BundleAlignment - 1) / BundleAlignment * BundleAlignment;
+}
+
+static bool writeBundle(const char* path){
+	BundleHeader header;
+	memcpy(header.Magic, BundleMagic, sizeof(header.Magic));
+	header.Version = BundleVersion;
+	header.Count = assets.size();
+
+	vector<BundleEntry> entries(assets.size());
+	size_t offset = aligned(sizeof(header) + entries.size() * sizeof(BundleEntry));
+	for(size_t i=0; i<assets.size(); i++){
+		memset(&entries[i], 0, sizeof(BundleEntry));
+		strncpy(entries[i].Name, assets[i].name.c_str(), sizeof(entries[i].Name));
+		entries[i].Offset = offset;
+		entries[i].Size = assets[i].data.size();
+		entries[i].SourceSize = assets[i].source.st_size;
+		entries[i].SourceTime = assets[i].source.st_mtime;
+		offset = aligned(offset + assets[i].data.size());
+	}
+
+	ofstream file(path, ios::out | ios::binary | ios::trunc);
+	if(!file.is_open())
+		return false;
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&entries[0], entries.size() * sizeof(BundleEntry));
+	size_t written = sizeof(header) + entries.size() * sizeof(BundleEntry);
+	static const char padding[BundleAlignment] = {0};
+	for(size_t i=0; i<assets.size(); i++){
+		file.write(padding, entries[i].Offset - written);
+		file.write(&assets[i].data[0], assets[i].data.size());
+		written = entries[i].Offset + assets[i].data.size();
+	}
+	return file.good();
+}
+
+int main (int argc, char** argv){
+	const char* output = argc > 1 ? argv[1] : "assets.bundle";
+
+	for(size_t i=0; i<sizeof(images)/sizeof(images[0]); i++)
+		if(!packImage(images[i])){
+			cerr << "Could not load image " << images[i] << ": " << SOIL_last_result() << endl;
+			return EXIT_FAILURE;
+		}
+	for(size_t i=0; i<sizeof(shaders)/sizeof(shaders[0]); i++)
+		if(!packShader(shaders[i])){
+			cerr << "Could not read shader " << shaders[i] << endl;
+			return EXIT_FAILURE;
+		}
+	// Both text modes, so --bitmap-text starts just as fast
+	if(!packFont(fontPath, FONT_SDF, fontPixelSize) || !packFont(fontPath, FONT_BITMAP, fontPixelSize)){
+		cerr << "Could not load font " << fontPath << endl;
+		return EXIT_FAILURE;
+	}
+
+	if(!writeBundle(output)){
+		cerr << "Could not write " << output << endl;
+		return EXIT_FAILURE;
+	}
+	size_t total = 0;
+	for(size_t i=0; i<assets.size(); i++){
+		cout << assets[i].name << ": " << assets[i].data.size() << " bytes" << endl;
+		total += assets[i].data.size();
+	}
+	cout << assets.size() << " assets, " << total << " bytes in " << output << endl;
+	return 0;
+}
@@ -1,12 +1,13 @@
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
+flat in float Layer;
 out vec4 color;
 
-uniform sampler2D text;
-uniform vec3 textColor;
+uniform sampler2DArray text;
 
 void main()
 {    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
-}  
+    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, vec3(TexCoords, Layer)).r);
+    color = vec4(TextColor, 1.0) * sampled;
+}
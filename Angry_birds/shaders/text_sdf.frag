@@ -0,0 +1,17 @@
+#version 330 core
+in vec2 TexCoords;
+in vec3 TextColor;
+flat in float Layer;
+out vec4 color;
+
+uniform sampler2DArray text;
+
+// The atlas stores signed distance to the outline, 0.5 is the edge.
+// Antialiasing over one screen pixel keeps the edge sharp at any scale.
+void main()
+{
+    float dist = texture(text, vec3(TexCoords, Layer)).r;
+    float width = fwidth(dist);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+    color = vec4(TextColor, alpha);
+}
@@ -0,0 +1,357 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "simulation.h"
+
+using namespace std;
+
+Body cannonball[2], woodlogs[6], pigs[10];
+int poscannonball=0;
+double pigsizea[6], pigsizeb[6];
+double woodsizex[6], woodsizey[6];
+
+int pressed_state = 0, collision_state=0;
+int keyboard_pressed_statex = 0, keyboard_pressed_statey = 0;
+double curx,cury,initx = -380,inity = 130,speedx,speedy,strength=0.5,prevx,prevy,cannonball_size=18,gravity=0.2;
+double fireposx=-380,fireposy=130, keyboardx = -380 , keyboardy = 130;
+double pivotx=-10,pivoty=-30,angular_v[6],angle[6],woodspx[6],woodspy[6],pigspx[10], pigspy[10], piginitx[10];
+int scoretimer[10][3],tim=5;
+int pig_wood[10];
+int score = 0, lives=4;
+double power = 0, birdangle = 0;
+static int birdjumped = 0;
+
+static Body makeBody(double centerx, double centery, double radius){
+	Body body;
+	body.centerx = centerx;
+	body.centery = centery;
+	body.radius = radius;
+	body.dead = 0;
+	return body;
+}
+
+void setupLevel ()
+{
+	//Pigs are ellipses, sizea is the horizontal and sizeb the vertical radius
+	double sizea[6]={18 + 5, 23 +5 , 20 + 5, 25 + 5, 20 + 5, 28 + 5},sizeb[6]={18, 23, 20, 25, 20, 28};
+	memcpy(pigsizea, sizea, sizeof(sizea));
+	memcpy(pigsizeb, sizeb, sizeof(sizeb));
+	pigs[0] = makeBody(50, 200-sizeb[0], sizea[0]);
+	pigs[1] = makeBody(345, 200-50-sizeb[1], sizea[1]);
+	pigs[2] = makeBody(415, 200-sizeb[2], sizea[2]);
+	pigs[3] = makeBody(280, 200-50-40-sizeb[3], sizea[3]);
+	pigs[4] = makeBody(70, -110 - 10- sizeb[4], sizea[4]);
+	pigs[5] = makeBody(100, -210 - 10- sizeb[5], sizea[4]);
+	piginitx[0]=50, piginitx[1]=345, piginitx[2] = 415, piginitx[3] = 280, piginitx[4] = 70,piginitx[5] = 100;
+	memset(pig_wood, 0, sizeof(pig_wood));
+	pig_wood[3] = 1;
+	pig_wood[1] = 2;
+
+	//Wood logs, woodsizex and woodsizey are half extents
+	woodsizex[0] = 10;
+	woodsizey[0] = 30;
+	woodsizex[1] = 35;
+	woodsizey[1] = 20;
+	woodsizex[2] = 75;
+	woodsizey[2] = 25;
+	woodsizex[3] = 10;
+	woodsizey[3] = 100;
+	woodsizex[4] = 50;
+	woodsizey[4] = 10;
+	woodsizex[5] = 50;
+	woodsizey[5] = 10;
+	woodlogs[0] = makeBody(0, 170, 25);
+	woodlogs[1] = makeBody(280, 130, 25);
+	woodlogs[2] = makeBody(310, 175, 25);
+	woodlogs[3] = makeBody(150, -200, 25);
+	woodlogs[4] = makeBody(90, -110, 25);
+	woodlogs[5] = makeBody(90, -210, 25);
+
+	//Birds, the second one is used once only two lives are left
+	//Both collide with the radius of the big one, as they always have
+	cannonball[0] = makeBody(0, 0, 18);
+	cannonball[1] = makeBody(0, 0, 40);
+	cannonball_size = 40;
+	poscannonball = 0;
+
+	//Nothing is moving at the start of a game
+	pressed_state = collision_state = 0;
+	keyboard_pressed_statex = keyboard_pressed_statey = 0;
+	curx = cury = speedx = speedy = prevx = prevy = 0;
+	initx = keyboardx = fireposx;
+	inity = keyboardy = fireposy;
+	gravity = 0.2;
+	pivotx = -10, pivoty = -30;
+	memset(angular_v, 0, sizeof(angular_v));
+	memset(angle, 0, sizeof(angle));
+	memset(woodspx, 0, sizeof(woodspx));
+	memset(woodspy, 0, sizeof(woodspy));
+	memset(pigspx, 0, sizeof(pigspx));
+	memset(pigspy, 0, sizeof(pigspy));
+	memset(scoretimer, 0, sizeof(scoretimer));
+	score = 0;
+	lives = 4;
+	power = 0;
+	birdangle = 0;
+}
+
+void simulate ()
+{
+	//Where the bird starts the tick, to tell a jump back to the sling from flight
+	int lastslot = poscannonball;
+	double lastx = cannonball[lastslot].centerx, lasty = cannonball[lastslot].centery;
+	birdjumped = 0;
+
+	//Moving pigs and counting them for score 
+	int cnt = 0;
+	for(int i=0;i<6;i++){
+		if(!pigs[i].dead){
+			double x1 = cannonball[poscannonball].centerx,y1 = cannonball[poscannonball].centery, x2 = pigs[i].centerx, y2 = pigs[i].centery;
+			if(pigs[i].radius + cannonball[poscannonball].radius > sqrt((x2-x1)*(x2-x1)+(y2-y1)*(y2-y1))){
+				pigs[i].dead = 1;
+				scoretimer[i][0] = pigs[i].centerx; 
+				scoretimer[i][1] = pigs[i].centery; 
+				scoretimer[i][2] = tim;
+				speedx = 0.1*speedx;
+				speedy = 0.1*speedy;
+			}
+
+			pigs[i].centerx += pigspx[i];
+			pigs[i].centery += pigspy[i];
+			pigspx[i]/= 1.02;
+		}
+		else
+			cnt++;
+	}
+
+	//Rotating the wood log hit by the bird
+	if(collision_state==1){
+		if(pivotx == -10){
+			angle[0] += angular_v[0];
+			angular_v[0] += 0.3;
+			angle[0] = min(angle[0],90.0);
+		}
+		else{
+			angle[0] -= angular_v[0];
+			angular_v[0] += 0.3;
+			angle[0] = max(angle[0],-90.0);
+		}
+		if(angle[0] >= 45){
+			pigs[0].dead = 1;
+			scoretimer[0][0]=pigs[0].centerx;
+			scoretimer[0][1]=pigs[0].centery;
+			scoretimer[0][2]=tim;
+		}
+	}
+
+	//Moving wood logs and checking collisions between pigs and wood logs
+	for(int i=1;i<=5;i++){
+		woodlogs[i].centerx += woodspx[i];
+		woodspx[i] /= 1.02;
+		if(i<=2&&woodlogs[i].centerx + woodsizex[i] > pigs[i].centerx - pigs[i].radius){
+			pigspx[i] = woodspx[i]*0.95;
+			woodspx[i]=woodspx[i]*0.9;
+			pigs[i].centerx = woodlogs[i].centerx + woodsizex[i] + pigs[i].radius;
+		}
+	}
+
+	//Checking collisions between pigs and pigs
+	for(int i=0;i<4;i++) {
+		if(pig_wood[i]!=0){
+			int j = pig_wood[i];
+			
+			if(j==1){
+				if(pigs[i].centerx+pigs[i].radius<woodlogs[j].centerx - woodsizex[j])
+					pigspy[i]+=gravity/3.0f;
+				if((pigs[i].centery+pigs[i].radius > woodlogs[j+1].centery - woodsizey[j+1])
+						||pigs[i].centery + pigs[i].radius > 200){
+					pigs[i].dead=1;
+					scoretimer[i][0] = pigs[i].centerx; 
+					scoretimer[i][1] = pigs[i].centery; 
+					scoretimer[i][2] = tim;
+				}
+
+			}
+			if(j==2){
+				if(pigs[i].centerx-pigs[i].radius>woodlogs[j].centerx + woodsizex[j])
+					pigspy[i]+=gravity/3.0f;
+				double x1 = pigs[i].centerx, y1 = pigs[i].centery, x2 = pigs[i+1].centerx, y2 = pigs[i+1].centery;
+				if(sqrt((x1-x2)*(x1-x2)+(y1-y2)*(y1-y2)) < pigs[i].radius + pigs[i+1].radius)
+				{
+					pigs[i].dead=pigs[i+1].dead = 1;
+					scoretimer[i][0] = pigs[i].centerx; 
+					scoretimer[i][1] = pigs[i].centery; 
+					scoretimer[i][2]=tim;
+					scoretimer[i+1][0] = pigs[i+1].centerx; 
+					scoretimer[i+1][1] = pigs[i+1].centery; 
+					scoretimer[i+1][2]=tim;
+				}
+				if(pigs[i].centery+pigs[i].radius>200){
+					pigs[i].dead=1;
+					scoretimer[i][0] = pigs[i].centerx; 
+					scoretimer[i][1] = pigs[i].centery; 
+					scoretimer[i][2]=tim;
+				}
+				
+			}
+		}
+	}
+
+	//Controlling bird using keyboard
+	if(keyboard_pressed_statex == 1){
+		keyboardy -= 2;
+		if(keyboardx < fireposx)
+			keyboardx += 2;
+		else if(keyboardx > fireposx)
+			keyboardx -= 2;
+		curx = keyboardx;
+		cury = keyboardy;
+	}
+	if(keyboard_pressed_statey == 1){
+		keyboardy += 2;
+		if(keyboardx < fireposx)
+			keyboardx -=2;
+		else if(keyboardx >fireposx)
+			keyboardx += 2;
+		curx = keyboardx;
+		cury = keyboardy;
+	}
+		
+	//Limiting the power with which bird can be shot
+	if(pressed_state==1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1)
+		if(sqrt((curx-initx)*(curx-initx)+(cury-inity)*(cury-inity)) > 70){
+			double angle_present = -M_PI+atan2(inity-cury,initx-curx);
+			curx = initx + 70*cos(angle_present);
+			cury = inity + 70*sin(angle_present);
+		}
+
+	//Placing the bird
+	if(pressed_state==0 && keyboard_pressed_statex == 0 && keyboard_pressed_statey == 0){
+		cannonball[poscannonball].centerx = fireposx;
+		cannonball[poscannonball].centery = fireposy;
+		cannonball[poscannonball].radius = cannonball_size;
+
+		if(lives<=2){
+			poscannonball=1;
+			cannonball[poscannonball].centerx = fireposx;
+			cannonball[poscannonball].centery = fireposy;
+			cannonball[poscannonball].radius = cannonball_size;
+		}	
+		birdjumped = poscannonball != lastslot || cannonball[poscannonball].centerx != lastx || cannonball[poscannonball].centery != lasty;
+	}
+	else if(pressed_state==1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1){
+		power = sqrt((curx-initx)*(curx-initx) + (cury-inity)*(cury-inity));
+		cannonball[poscannonball].centerx = curx;
+		cannonball[poscannonball].centery = cury;
+		cannonball[poscannonball].radius = cannonball_size;
+	}
+	else {
+		cannonball[poscannonball].centerx = initx;
+		cannonball[poscannonball].centery = inity;
+		cannonball[poscannonball].radius = cannonball_size;
+	}
+	if(collision_state == 0 && cannonball[poscannonball].centerx >= -10 - cannonball_size && cannonball[poscannonball].centerx <= -10 + 20 + cannonball_size && cannonball[poscannonball].centery >= 140 - cannonball_size ){
+		collision_state=1;
+		angle[0] = 0.1;
+		angular_v[0] = speedx*0.2;
+		if(cannonball[poscannonball].centerx > 10){
+			pivotx = 10;
+			angle[0] = -0.1;
+			angular_v[0] = -speedx*0.2;
+		}
+		if(cannonball[poscannonball].centery < 140 && cannonball[poscannonball].centerx > -10 - cannonball_size/2 && (cannonball[poscannonball].centerx < 10 + cannonball_size/2)){
+			speedy = -0.5*speedy;
+			inity = 140 - cannonball_size - 1;
+		}
+		else{
+			speedx = -0.5*speedx;
+		}
+	}
+
+	for(int i=1;i<=5;i++){
+		double x = cannonball[poscannonball].centerx,y = cannonball[poscannonball].centery;
+		if(x >= woodlogs[i].centerx - woodsizex[i] - cannonball_size && x <= woodlogs[i].centerx + woodsizex[i] + cannonball_size && y >= woodlogs[i].centery - woodsizey[i] - cannonball_size && y <= woodlogs[i].centery + woodsizey[i]) {
+			if(cannonball[poscannonball].centery < woodlogs[i].centery - woodsizey[i] && cannonball[poscannonball].centerx > woodlogs[i].centerx - woodsizex[i] - cannonball_size/2 ){
+				speedy = -0.25*speedy, speedx = 0.25*speedx;
+				inity = woodlogs[i].centery - woodsizey[i] - cannonball_size - 1;
+			}
+			else {
+				if(i==1){
+					woodspx[1] = speedx * 0.1;
+					woodspx[2] = woodspx[1] * 0.1;
+				}
+				else if(i==2){
+					woodspx[2] = speedx * 0.05;
+					woodspx[1] = woodspx[2] * 0.5;
+				}
+				speedx = -0.25*speedx, speedy = 0.25*speedy;
+				initx = woodlogs[i].centerx - woodsizex[i] - cannonball_size - 1;
+			}
+			break;
+		}
+	}
+
+	//Bird faces the direction it is flying, or away from the sling while it is pulled
+	if(pressed_state==3) 
+		birdangle = atan2(-prevy+inity,-prevx+initx);
+	else if(pressed_state==1 || keyboard_pressed_statex == 1 || keyboard_pressed_statey == 1)
+		birdangle = atan2(-cury+inity,-curx+initx);
+	else
+		birdangle = 0;
+
+	//Flying bird
+	if(pressed_state==3){
+		prevx=initx,prevy=inity;
+		initx=initx+speedx,inity=inity+speedy,speedy+=gravity;
+		inity=min(200-cannonball_size,inity);
+		if(inity==200-cannonball_size)
+			speedy=-0.8*speedy,speedx=0.7*speedx;
+		if(fabs(speedx)<=0.05&&fabs(speedy)<=0.05){
+				pressed_state=0;
+				gravity = 0.2;
+				power = 0;
+			
+		}
+	}
+
+	score = cnt * 100;
+}
+
+void releaseBird (double &pullx, double &pully)
+{
+	pressed_state=3;
+	if(sqrt((pullx-initx)*(pullx-initx)+(pully-inity)*(pully-inity)) > 30){
+		double angle_present = -M_PI+atan2(inity-pully,initx-pullx);
+		pullx = initx + 30*cos(angle_present);
+		pully = inity + 30*sin(angle_present);
+	}
+	speedx=(initx-pullx)*strength;
+	speedy=(inity-pully)*strength;
+}
+
+void resetBird ()
+{
+	pressed_state=0;
+	gravity = 0.2;
+	power = 0;
+	keyboardx = fireposx;
+	keyboardy = fireposy;
+}
+
+SimSnapshot takeSnapshot ()
+{
+	SimSnapshot s;
+	for(int i=0;i<6;i++){
+		s.pigx[i] = pigs[i].centerx;
+		s.pigy[i] = pigs[i].centery;
+		s.woodx[i] = woodlogs[i].centerx;
+		s.woody[i] = woodlogs[i].centery;
+	}
+	s.birdx = cannonball[poscannonball].centerx;
+	s.birdy = cannonball[poscannonball].centery;
+	s.birdangle = birdangle;
+	s.logangle = angle[0];
+	s.birdjumped = birdjumped;
+	return s;
+}
@@ -0,0 +1,57 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+/* Game state and rules: pigs, wood logs, the bird and scoring */
+/* Nothing in here touches GLFW or OpenGL, so it also runs in the headless build */
+
+/* Physical part of a game object, its mesh lives with the renderer */
+struct Body {
+	double centerx;
+	double centery;
+	double radius;
+	int dead;
+};
+
+/* Fixed simulation rate, independent from how fast frames are rendered */
+const double SIM_TIMESTEP = 1.0/60.0;
+
+extern Body cannonball[2], woodlogs[6], pigs[10];
+extern int poscannonball;
+extern double pigsizea[6], pigsizeb[6];
+extern double woodsizex[6], woodsizey[6];
+
+extern int pressed_state, collision_state;
+extern int keyboard_pressed_statex, keyboard_pressed_statey;
+extern double curx, cury, initx, inity, speedx, speedy, strength, prevx, prevy, cannonball_size, gravity;
+extern double fireposx, fireposy, keyboardx, keyboardy;
+extern double pivotx, pivoty, angular_v[6], angle[6], woodspx[6], woodspy[6], pigspx[10], pigspy[10], piginitx[10];
+extern int scoretimer[10][3], tim;
+extern int pig_wood[10];
+extern int score, lives;
+extern double power, birdangle;
+
+/* Positions and angles of every moving object, captured after each simulation tick */
+/* The renderer blends the last two snapshots so motion stays smooth at any frame rate */
+struct SimSnapshot {
+	double pigx[10], pigy[10];
+	double woodx[6], woody[6];
+	double birdx, birdy, birdangle;
+	double logangle;
+	int birdjumped;	/* bird was put back on the sling or swapped during the tick, it must not be blended from where it was */
+};
+
+/* Place pigs, wood logs and the bird for a new game */
+void setupLevel ();
+
+/* Advance the game by one fixed tick: movement, collisions and scoring */
+void simulate ();
+
+/* Let the bird go from the point it was pulled to, clamped to the sling length */
+void releaseBird (double &pullx, double &pully);
+
+/* Put the bird back on the sling after a shot */
+void resetBird ();
+
+SimSnapshot takeSnapshot ();
+
+#endif